@@ -2,6 +2,83 @@
 
 namespace fusion {
 
+namespace {
+
+/* Chunked free-list pool for AST nodes. Nodes are handed out in allocation
+ * order from large slabs, so a freshly built tree lies roughly contiguous in
+ * memory and traversals stream instead of chasing malloc placements. delete
+ * pushes nodes onto a free list for reuse. Single-threaded, like the rest of
+ * the frontend.
+ *
+ * A struct-of-arrays node store (separate kind/operand/name streams keyed by
+ * node index) was evaluated as the next step and rejected: every consumer of
+ * the AST — parser, sema, codegen, multifile merge, the LSP index — works on
+ * owning node pointers, and the locality win over this pool does not pay
+ * for rewriting all of them. The pool plus the tight field packing on Expr
+ * (1-byte enums, 32-bit positions, cached sym/type in padding) captures most
+ * of the cache benefit while keeping the node API unchanged. */
+class NodePool {
+ public:
+  explicit NodePool(size_t node_size) : node_size_(node_size) {}
+
+  void* alloc() {
+    if (free_list_) {
+      FreeNode* n = free_list_;
+      free_list_ = n->next;
+      return n;
+    }
+    if (chunks_.empty() || used_ == kChunkNodes) {
+      chunks_.emplace_back(new unsigned char[node_size_ * kChunkNodes]);
+      used_ = 0;
+    }
+    return chunks_.back().get() + node_size_ * used_++;
+  }
+
+  void release(void* p) noexcept {
+    FreeNode* n = static_cast<FreeNode*>(p);
+    n->next = free_list_;
+    free_list_ = n;
+  }
+
+ private:
+  static constexpr size_t kChunkNodes = 1024;
+  struct FreeNode { FreeNode* next; };
+  size_t node_size_;
+  std::vector<std::unique_ptr<unsigned char[]>> chunks_;
+  size_t used_ = 0;
+  FreeNode* free_list_ = nullptr;
+};
+
+NodePool& expr_pool() {
+  static NodePool pool(sizeof(Expr));
+  return pool;
+}
+
+NodePool& stmt_pool() {
+  static NodePool pool(sizeof(Stmt));
+  return pool;
+}
+
+}  // namespace
+
+void* Expr::operator new(size_t size) {
+  (void)size;  // Expr has no subclasses
+  return expr_pool().alloc();
+}
+
+void Expr::operator delete(void* p) noexcept {
+  if (p) expr_pool().release(p);
+}
+
+void* Stmt::operator new(size_t size) {
+  (void)size;
+  return stmt_pool().alloc();
+}
+
+void Stmt::operator delete(void* p) noexcept {
+  if (p) stmt_pool().release(p);
+}
+
 ExprPtr Expr::make_int(int64_t value) {
   auto e = std::make_unique<Expr>();
   e->kind = Kind::IntLiteral;
@@ -3,23 +3,25 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 
 namespace fusion {
 
-enum class BinOp {
+/* Enums carried on every AST node use a 1-byte representation to keep Expr
+ * compact (see the field packing note on Expr). */
+enum class BinOp : uint8_t {
   Add,
   Sub,
   Mul,
   Div
 };
 
-enum class CompareOp {
+enum class CompareOp : uint8_t {
   Eq,
   Ne,
   Lt,
@@ -29,7 +31,7 @@ enum class CompareOp {
 };
 
 /* FFI type kind, matches rt_ffi_type_kind_t. */
-enum class FfiType {
+enum class FfiType : uint8_t {
   Void,
   I8,
   I32,
@@ -43,7 +45,7 @@ struct Expr;
 using ExprPtr = std::unique_ptr<Expr>;
 
 struct Expr {
-  enum class Kind {
+  enum class Kind : uint8_t {
     IntLiteral,
     FloatLiteral,
     StringLiteral,
@@ -71,15 +73,41 @@ struct Expr {
     Compare,
     Index
   };
+  /* Small fields are grouped and sized tightly (1-byte enums, 32-bit source
+   * positions) so each node wastes as little of a cache line as possible. */
   Kind kind = Kind::IntLiteral;
+  BinOp bin_op = BinOp::Add;
+  CompareOp compare_op = CompareOp::Eq;
+  /* Result type for an inferred call(ptr, ...) signature; see below. */
+  FfiType inferred_call_result_type = FfiType::Void;
+
+  /* Source position for error reporting; 0 = unknown. */
+  uint32_t line = 0;
+  uint32_t column = 0;
+
+  /* Interned symbol id for callee (Call) or var_name (VarRef), resolved and
+   * cached by sema on first lookup; 0 = not yet resolved. Valid only for the
+   * sema run on the program this node belongs to (parsing always produces
+   * fresh nodes, and clone() deliberately leaves it 0). Sits in otherwise
+   * dead padding, so it costs nothing. */
+  uint32_t sym = 0;
+
+  /* Memoized static type (an FfiType value), filled by sema the first time
+   * the node is typed; 0xFF = not computed. A node's type never changes
+   * within a run, so repeated typing of shared subtrees is a byte load. */
+  uint8_t cached_type = 0xFF;
+
+  /* Set by sema once this node has checked successfully, so overlapping
+   * validation passes (e.g. call-site signature inference followed by the
+   * argument loop) do not re-walk the subtree. Same lifetime rules as sym:
+   * valid for one sema run, left unset by clone(). */
+  uint8_t checked = 0;
 
   int64_t int_value = 0;
   double float_value = 0.0;
-  std::string str_value;
-  BinOp bin_op = BinOp::Add;
-  CompareOp compare_op = CompareOp::Eq;
   ExprPtr left;
   ExprPtr right;
+  std::string str_value;
   std::string callee;
   std::vector<ExprPtr> args;
   std::string call_type_arg;  // optional type arg for Call: e.g. range elem type, from_str result type; "" = none
@@ -90,14 +118,16 @@ struct Expr {
 
   /* When non-empty, sema inferred the call signature for call(ptr, ...); codegen uses this. */
   std::vector<FfiType> inferred_call_param_types;
-  FfiType inferred_call_result_type = FfiType::Void;
 
   /* Ptr element type inferred by sema: "" = unknown/void, "char" = string, struct name = typed ptr. */
   std::string inferred_ptr_element;
 
-  /* Source position for error reporting; 0 = unknown. */
-  size_t line = 0;
-  size_t column = 0;
+  /* Nodes come from a chunked pool (ast.cpp) so allocation order — roughly
+   * parse order — correlates with memory order, keeping traversals
+   * cache-friendly. unique_ptr ownership is unchanged; delete returns the
+   * node to the pool. The frontend is single-threaded. */
+  static void* operator new(size_t size);
+  static void operator delete(void* p) noexcept;
 
   static ExprPtr make_int(int64_t value);
   static ExprPtr make_float(double value);
@@ -186,6 +216,10 @@ struct Stmt {
   StmtPtr for_init;   // for For (Let or Assign, optional)
   StmtPtr for_update; // for For (Assign, optional)
   std::vector<StmtPtr> body;        // for For
+  /* Pooled like Expr; see ast.cpp. */
+  static void* operator new(size_t size);
+  static void operator delete(void* p) noexcept;
+
   static StmtPtr make_return(ExprPtr expr);
   static StmtPtr make_let(std::string name, ExprPtr init);
   static StmtPtr make_expr(ExprPtr expr);
@@ -242,40 +276,67 @@ struct Program {
 
 // Returns the FfiType for a known builtin call with a fixed return type, or std::nullopt if
 // not a simple fixed-return builtin. Callers handle "call" and "from_str" separately.
+// Dispatches on length first so a miss costs one jump and at most a few memcmps
+// instead of a hash of the whole name.
 inline std::optional<FfiType> builtin_fixed_return_type(const std::string& callee) {
-  static const std::unordered_map<std::string, FfiType> table = {
-    {"get_func_ptr",    FfiType::Ptr},
-    {"print",           FfiType::Void},
-    {"println",         FfiType::Void},
-    {"len",             FfiType::I64},
-    {"read_line",       FfiType::Ptr},
-    {"read_line_file",  FfiType::Ptr},
-    {"to_str",          FfiType::Ptr},
-    {"open",            FfiType::Ptr},
-    {"close",           FfiType::Void},
-    {"write_file",      FfiType::Void},
-    {"eof_file",        FfiType::I64},
-    {"line_count_file", FfiType::I64},
-    {"read_key",        FfiType::I64},
-    {"terminal_height", FfiType::I64},
-    {"terminal_width",  FfiType::I64},
-    {"flush",           FfiType::Void},
-    {"sleep",           FfiType::Void},
-    {"chr",             FfiType::Ptr},
-    {"write_bytes",     FfiType::I64},
-    {"read_bytes",      FfiType::I64},
-    {"http_request",    FfiType::Ptr},
-    {"http_status",     FfiType::I64},
-    {"str_dup",         FfiType::Ptr},
-    {"str_upper",       FfiType::Ptr},
-    {"str_lower",       FfiType::Ptr},
-    {"str_contains",    FfiType::I64},
-    {"str_strip",       FfiType::Ptr},
-    {"str_find",        FfiType::I64},
-    {"str_split",       FfiType::Ptr},
-  };
-  auto it = table.find(callee);
-  if (it != table.end()) return it->second;
+  const char* s = callee.data();
+  switch (callee.size()) {
+    case 3:
+      if (std::memcmp(s, "len", 3) == 0) return FfiType::I64;
+      if (std::memcmp(s, "chr", 3) == 0) return FfiType::Ptr;
+      break;
+    case 4:
+      if (std::memcmp(s, "open", 4) == 0) return FfiType::Ptr;
+      break;
+    case 5:
+      if (std::memcmp(s, "print", 5) == 0) return FfiType::Void;
+      if (std::memcmp(s, "close", 5) == 0) return FfiType::Void;
+      if (std::memcmp(s, "flush", 5) == 0) return FfiType::Void;
+      if (std::memcmp(s, "sleep", 5) == 0) return FfiType::Void;
+      break;
+    case 6:
+      if (std::memcmp(s, "to_str", 6) == 0) return FfiType::Ptr;
+      break;
+    case 7:
+      if (std::memcmp(s, "println", 7) == 0) return FfiType::Void;
+      if (std::memcmp(s, "str_dup", 7) == 0) return FfiType::Ptr;
+      break;
+    case 8:
+      if (std::memcmp(s, "eof_file", 8) == 0) return FfiType::I64;
+      if (std::memcmp(s, "read_key", 8) == 0) return FfiType::I64;
+      if (std::memcmp(s, "str_find", 8) == 0) return FfiType::I64;
+      break;
+    case 9:
+      if (std::memcmp(s, "read_line", 9) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "str_upper", 9) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "str_lower", 9) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "str_strip", 9) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "str_split", 9) == 0) return FfiType::Ptr;
+      break;
+    case 10:
+      if (std::memcmp(s, "write_file", 10) == 0) return FfiType::Void;
+      if (std::memcmp(s, "read_bytes", 10) == 0) return FfiType::I64;
+      break;
+    case 11:
+      if (std::memcmp(s, "write_bytes", 11) == 0) return FfiType::I64;
+      if (std::memcmp(s, "http_status", 11) == 0) return FfiType::I64;
+      break;
+    case 12:
+      if (std::memcmp(s, "get_func_ptr", 12) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "http_request", 12) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "str_contains", 12) == 0) return FfiType::I64;
+      break;
+    case 14:
+      if (std::memcmp(s, "read_line_file", 14) == 0) return FfiType::Ptr;
+      if (std::memcmp(s, "terminal_width", 14) == 0) return FfiType::I64;
+      break;
+    case 15:
+      if (std::memcmp(s, "line_count_file", 15) == 0) return FfiType::I64;
+      if (std::memcmp(s, "terminal_height", 15) == 0) return FfiType::I64;
+      break;
+    default:
+      break;
+  }
   return std::nullopt;
 }
 
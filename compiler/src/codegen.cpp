@@ -3,6 +3,7 @@
 #include "layout.hpp"
 #include "sema.hpp"
 #include <variant>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "codegen_pch.hpp"
@@ -2490,7 +2491,23 @@ CodegenResult run_jit(std::unique_ptr<llvm::Module> module,
     return true;
   }();
   (void)native_target_init;
-  auto JITOrErr = LLJITBuilder().create();
+  /* Host triple/CPU-feature detection parses /proc/cpuinfo and feature
+   * strings on every detectHost(); run it once per process and hand each
+   * LLJIT a copy of the result. */
+  static const JITTargetMachineBuilder host_jtmb = []() {
+    auto detected = JITTargetMachineBuilder::detectHost();
+    if (!detected) {
+      consumeError(detected.takeError());
+      detected = JITTargetMachineBuilder(Triple(sys::getProcessTriple()));
+    }
+    /* JIT'd programs are run-once scripts, so instruction selection speed
+     * matters more than code quality: pick O0 with FastISel. emit_object
+     * keeps the default optimizing pipeline for ahead-of-time builds. */
+    detected->setCodeGenOptLevel(CodeGenOptLevel::None);
+    detected->getOptions().EnableFastISel = true;
+    return std::move(*detected);
+  }();
+  auto JITOrErr = LLJITBuilder().setJITTargetMachineBuilder(host_jtmb).create();
   if (!JITOrErr) {
     r.error = "failed to create LLJIT: " + llvm::toString(JITOrErr.takeError());
     return r;
@@ -2504,47 +2521,66 @@ CodegenResult run_jit(std::unique_ptr<llvm::Module> module,
   }
   JIT->getMainJITDylib().addGenerator(std::move(*genOrErr));
 
-  /* Resolve runtime symbols: RTLD_DEFAULT can miss main-exe symbols on some PIE setups; try main exe explicitly. */
-  void* main_handle = nullptr;
-  auto add_sym = [&](const char* name) {
-    void* addr = dlsym(RTLD_DEFAULT, name);
-    if (!addr && !main_handle) {
-      main_handle = dlopen(nullptr, RTLD_NOW);
-    }
-    if (!addr && main_handle) {
-      addr = dlsym(main_handle, name);
-    }
-    if (!addr) return false;
-    SymbolMap syms;
-    syms[JIT->mangleAndIntern(name)] = ExecutorSymbolDef(
-        ExecutorAddr::fromPtr(addr), JITSymbolFlags::Callable | JITSymbolFlags::Exported);
-    if (auto err = JIT->getMainJITDylib().define(absoluteSymbols(std::move(syms)))) return false;
-    return true;
+  /* Resolve runtime symbols. Their addresses are fixed for the life of the
+   * process (the runtime is linked in), so walk dlsym once and define the
+   * cached addresses into each JIT's dylib. RTLD_DEFAULT can miss main-exe
+   * symbols on some PIE setups; try the main exe explicitly as fallback. */
+  struct RuntimeSymbols {
+    std::vector<std::pair<const char*, void*>> addrs;
+    const char* first_missing = nullptr;
+    std::string dl_error;
   };
-  const char* first_missing = nullptr;
-  auto check_sym = [&](const char* name) {
-    if (!add_sym(name)) {
-      if (!first_missing) first_missing = name;
-      return false;
+  static const RuntimeSymbols runtime_syms = []() {
+    static const char* const kNames[] = {
+        "rt_print_cstring", "rt_panic",
+        "rt_read_line", "rt_read_key", "rt_terminal_height", "rt_terminal_width",
+        "rt_flush", "rt_chr", "rt_to_str_i64", "rt_to_str_f64",
+        "rt_from_str_i64", "rt_from_str_f64", "rt_str_concat", "rt_str_dup",
+        "rt_str_upper", "rt_str_lower", "rt_str_contains",
+        "rt_str_strip", "rt_str_find", "rt_str_split", "rt_str_eq",
+        "rt_open", "rt_close", "rt_read_line_file",
+        "rt_write_file_ptr",
+        "rt_write_bytes", "rt_read_bytes",
+        "rt_eof_file", "rt_line_count_file",
+        "rt_http_request", "rt_http_status",
+        "rt_dlopen", "rt_dlsym", "rt_dlerror_last",
+        "rt_ffi_sig_create", "rt_ffi_call", "rt_ffi_error_last"};
+    RuntimeSymbols rs;
+    void* main_handle = nullptr;
+    for (const char* name : kNames) {
+      void* addr = dlsym(RTLD_DEFAULT, name);
+      if (!addr && !main_handle) {
+        main_handle = dlopen(nullptr, RTLD_NOW);
+      }
+      if (!addr && main_handle) {
+        addr = dlsym(main_handle, name);
+      }
+      if (!addr) {
+        if (!rs.first_missing) {
+          rs.first_missing = name;
+          const char* err = dlerror();
+          if (err) rs.dl_error = err;
+        }
+        continue;
+      }
+      rs.addrs.emplace_back(name, addr);
     }
-    return true;
-  };
-  if (!check_sym("rt_print_cstring") || !check_sym("rt_panic") ||
-      !check_sym("rt_read_line") || !check_sym("rt_read_key") || !check_sym("rt_terminal_height") || !check_sym("rt_terminal_width") || !check_sym("rt_flush") || !check_sym("rt_chr") || !check_sym("rt_to_str_i64") || !check_sym("rt_to_str_f64") ||
-      !check_sym("rt_from_str_i64") || !check_sym("rt_from_str_f64") || !check_sym("rt_str_concat") || !check_sym("rt_str_dup") ||
-      !check_sym("rt_str_upper") || !check_sym("rt_str_lower") || !check_sym("rt_str_contains") ||
-      !check_sym("rt_str_strip") || !check_sym("rt_str_find") || !check_sym("rt_str_split") || !check_sym("rt_str_eq") ||
-      !check_sym("rt_open") || !check_sym("rt_close") || !check_sym("rt_read_line_file") ||
-      !check_sym("rt_write_file_ptr") ||
-      !check_sym("rt_write_bytes") || !check_sym("rt_read_bytes") ||
-      !check_sym("rt_eof_file") || !check_sym("rt_line_count_file") ||
-      !check_sym("rt_http_request") || !check_sym("rt_http_status") ||
-      !check_sym("rt_dlopen") || !check_sym("rt_dlsym") || !check_sym("rt_dlerror_last") ||
-      !check_sym("rt_ffi_sig_create") || !check_sym("rt_ffi_call") || !check_sym("rt_ffi_error_last")) {
+    return rs;
+  }();
+  if (runtime_syms.first_missing) {
     r.error = "runtime symbols not found (link runtime or use dlsym)";
-    if (first_missing) r.error += std::string("; first missing: ") + first_missing;
-    const char* err = dlerror();
-    if (err) r.error += std::string("; dlerror: ") + err;
+    r.error += std::string("; first missing: ") + runtime_syms.first_missing;
+    if (!runtime_syms.dl_error.empty()) r.error += "; dlerror: " + runtime_syms.dl_error;
+    return r;
+  }
+  SymbolMap rt_syms;
+  for (const auto& entry : runtime_syms.addrs) {
+    rt_syms[JIT->mangleAndIntern(entry.first)] = ExecutorSymbolDef(
+        ExecutorAddr::fromPtr(entry.second), JITSymbolFlags::Callable | JITSymbolFlags::Exported);
+  }
+  if (auto err = JIT->getMainJITDylib().define(absoluteSymbols(std::move(rt_syms)))) {
+    consumeError(std::move(err));
+    r.error = "failed to define runtime symbols";
     return r;
   }
 
@@ -69,11 +69,15 @@ StructLayout compute_layout(const StructDef& def, const LayoutMap& known_layouts
     if (rem != 0) offset += alignment - rem;
   }
   out.size = offset;
+  out.field_index.reserve(out.fields.size());
+  for (uint32_t i = 0; i < out.fields.size(); ++i)
+    out.field_index.emplace(out.fields[i].first, i);
   return out;
 }
 
 LayoutMap build_layout_map(const std::vector<StructDef>& struct_defs) {
   LayoutMap map;
+  map.reserve(struct_defs.size());
   // Iterative topological resolution: keep computing until stable
   size_t prev_size = 0;
   while (map.size() < struct_defs.size()) {
@@ -3,6 +3,7 @@
 
 #include "ast.hpp"
 #include <cstddef>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -36,6 +37,15 @@ struct StructLayout {
   size_t size = 0;
   size_t alignment = 0;
   std::vector<std::pair<std::string, FieldLayout>> fields;
+  /* name -> index into fields, built by compute_layout. fields stays the
+   * ordered source of truth; the index makes per-access lookups O(1). */
+  std::unordered_map<std::string, uint32_t> field_index;
+
+  const FieldLayout* find_field(const std::string& name) const {
+    auto it = field_index.find(name);
+    if (it == field_index.end()) return nullptr;
+    return &fields[it->second].second;
+  }
 };
 
 /* Map struct name -> layout. Build from Program::struct_defs. */
@@ -1,39 +1,69 @@
 #include "lexer.hpp"
 #include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 namespace fusion {
 
+static Token punct(TokenKind kind, size_t line, size_t column) {
+  Token t;
+  t.kind = kind;
+  t.line = static_cast<uint32_t>(line);
+  t.column = static_cast<uint32_t>(column);
+  return t;
+}
+
+/* Keyword lookup dispatching on length first, then memcmp against the few
+ * candidates of that length — one jump plus at most a handful of fixed-size
+ * compares instead of up to 24 string equality checks per identifier. Same
+ * shape as builtin_fixed_return_type() in ast.hpp. */
 static TokenKind keyword_from_ident(const std::string& ident) {
-  if (ident == "extern") return TokenKind::KwExtern;
-  if (ident == "import") return TokenKind::KwImport;
-  if (ident == "export") return TokenKind::KwExport;
-  if (ident == "lib") return TokenKind::KwLib;
-  if (ident == "fn") return TokenKind::KwFn;
-  if (ident == "f64") return TokenKind::KwF64;
-  if (ident == "f32") return TokenKind::KwF32;
-  if (ident == "i64") return TokenKind::KwI64;
-  if (ident == "i32") return TokenKind::KwI32;
-  if (ident == "u64") return TokenKind::KwU64;
-  if (ident == "u32") return TokenKind::KwU32;
-  if (ident == "void") return TokenKind::KwVoid;
-  if (ident == "ptr") return TokenKind::KwPtr;
-  if (ident == "char") return TokenKind::KwChar;
-  if (ident == "as") return TokenKind::KwAs;
-  if (ident == "let") return TokenKind::KwLet;
-  if (ident == "return") return TokenKind::KwReturn;
-  if (ident == "opaque") return TokenKind::KwOpaque;
-  if (ident == "struct") return TokenKind::KwStruct;
-  if (ident == "if") return TokenKind::KwIf;
-  if (ident == "else") return TokenKind::KwElse;
-  if (ident == "elif") return TokenKind::KwElif;
-  if (ident == "for") return TokenKind::KwFor;
-  if (ident == "in") return TokenKind::KwIn;
+  const char* s = ident.data();
+  switch (ident.size()) {
+    case 2:
+      if (std::memcmp(s, "fn", 2) == 0) return TokenKind::KwFn;
+      if (std::memcmp(s, "as", 2) == 0) return TokenKind::KwAs;
+      if (std::memcmp(s, "if", 2) == 0) return TokenKind::KwIf;
+      if (std::memcmp(s, "in", 2) == 0) return TokenKind::KwIn;
+      break;
+    case 3:
+      if (std::memcmp(s, "lib", 3) == 0) return TokenKind::KwLib;
+      if (std::memcmp(s, "f64", 3) == 0) return TokenKind::KwF64;
+      if (std::memcmp(s, "f32", 3) == 0) return TokenKind::KwF32;
+      if (std::memcmp(s, "i64", 3) == 0) return TokenKind::KwI64;
+      if (std::memcmp(s, "i32", 3) == 0) return TokenKind::KwI32;
+      if (std::memcmp(s, "u64", 3) == 0) return TokenKind::KwU64;
+      if (std::memcmp(s, "u32", 3) == 0) return TokenKind::KwU32;
+      if (std::memcmp(s, "ptr", 3) == 0) return TokenKind::KwPtr;
+      if (std::memcmp(s, "let", 3) == 0) return TokenKind::KwLet;
+      if (std::memcmp(s, "for", 3) == 0) return TokenKind::KwFor;
+      break;
+    case 4:
+      if (std::memcmp(s, "void", 4) == 0) return TokenKind::KwVoid;
+      if (std::memcmp(s, "char", 4) == 0) return TokenKind::KwChar;
+      if (std::memcmp(s, "else", 4) == 0) return TokenKind::KwElse;
+      if (std::memcmp(s, "elif", 4) == 0) return TokenKind::KwElif;
+      break;
+    case 6:
+      if (std::memcmp(s, "extern", 6) == 0) return TokenKind::KwExtern;
+      if (std::memcmp(s, "import", 6) == 0) return TokenKind::KwImport;
+      if (std::memcmp(s, "export", 6) == 0) return TokenKind::KwExport;
+      if (std::memcmp(s, "return", 6) == 0) return TokenKind::KwReturn;
+      if (std::memcmp(s, "opaque", 6) == 0) return TokenKind::KwOpaque;
+      if (std::memcmp(s, "struct", 6) == 0) return TokenKind::KwStruct;
+      break;
+    default:
+      break;
+  }
   return TokenKind::Ident;
 }
 
-std::vector<Token> lex(const std::string& source) {
+std::vector<Token> lex(std::string_view source) {
   std::vector<Token> tokens;
+  /* Tokens average a handful of source bytes each; one sized allocation up
+   * front replaces the doubling regrowth (and Token moves) during the scan. */
+  tokens.reserve(source.size() / 4 + 16);
   size_t i = 0;
   size_t line = 1;
   size_t column = 1;
@@ -51,8 +81,21 @@ std::vector<Token> lex(const std::string& source) {
   };
 
   while (i < source.size()) {
-    while (i < source.size() && (source[i] == ' ' || source[i] == '\t' || source[i] == '\n' || source[i] == '\r')) {
-      advance();
+    /* Indentation is runs of plain spaces; consume those eight bytes at a
+     * time (one 64-bit compare per block). Tabs, newlines and short runs —
+     * which need the line/column bookkeeping — go through advance(). */
+    for (;;) {
+      while (i + 8 <= source.size()) {
+        uint64_t w;
+        std::memcpy(&w, source.data() + i, 8);
+        if (w != 0x2020202020202020ULL) break;
+        i += 8;
+        column += 8;
+      }
+      if (i < source.size() && (source[i] == ' ' || source[i] == '\t' || source[i] == '\n' || source[i] == '\r'))
+        advance();
+      else
+        break;
     }
     if (i >= source.size()) break;
 
@@ -97,8 +140,8 @@ std::vector<Token> lex(const std::string& source) {
       Token t;
       t.kind = TokenKind::StringLiteral;
       t.str_value = std::move(str_val);
-      t.line = start_line;
-      t.column = start_col;
+      t.line = static_cast<uint32_t>(start_line);
+      t.column = static_cast<uint32_t>(start_col);
       tokens.push_back(std::move(t));
       continue;
     }
@@ -123,15 +166,15 @@ std::vector<Token> lex(const std::string& source) {
         Token t;
         t.kind = TokenKind::FloatLiteral;
         t.float_value = float_val;
-        t.line = start_line;
-        t.column = start_col;
+        t.line = static_cast<uint32_t>(start_line);
+        t.column = static_cast<uint32_t>(start_col);
         tokens.push_back(std::move(t));
       } else {
         Token t;
         t.kind = TokenKind::IntLiteral;
         t.int_value = int_val;
-        t.line = start_line;
-        t.column = start_col;
+        t.line = static_cast<uint32_t>(start_line);
+        t.column = static_cast<uint32_t>(start_col);
         tokens.push_back(std::move(t));
       }
       continue;
@@ -147,125 +190,125 @@ std::vector<Token> lex(const std::string& source) {
       Token t;
       t.kind = keyword_from_ident(ident);
       t.ident = std::move(ident);
-      t.line = start_line;
-      t.column = start_col;
+      t.line = static_cast<uint32_t>(start_line);
+      t.column = static_cast<uint32_t>(start_col);
       tokens.push_back(std::move(t));
       continue;
     }
 
     if (source[i] == '-' && i + 1 < source.size() && source[i + 1] == '>') {
-      tokens.push_back({TokenKind::Arrow, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Arrow, start_line, start_col));
       advance();
       advance();
       continue;
     }
     if (source[i] == '-') {
-      tokens.push_back({TokenKind::Minus, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Minus, start_line, start_col));
       advance();
       continue;
     }
 
     if (source[i] == '(') {
-      tokens.push_back({TokenKind::LParen, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::LParen, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == ')') {
-      tokens.push_back({TokenKind::RParen, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::RParen, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '{') {
-      tokens.push_back({TokenKind::LCurly, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::LCurly, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '}') {
-      tokens.push_back({TokenKind::RCurly, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::RCurly, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '[') {
-      tokens.push_back({TokenKind::LBracket, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::LBracket, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == ']') {
-      tokens.push_back({TokenKind::RBracket, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::RBracket, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '+') {
-      tokens.push_back({TokenKind::Plus, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Plus, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '*') {
-      tokens.push_back({TokenKind::Star, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Star, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '/') {
-      tokens.push_back({TokenKind::Slash, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Slash, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == ',') {
-      tokens.push_back({TokenKind::Comma, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Comma, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == ';') {
-      tokens.push_back({TokenKind::Semicolon, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Semicolon, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == ':') {
-      tokens.push_back({TokenKind::Colon, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Colon, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '.') {
-      tokens.push_back({TokenKind::Dot, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Dot, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '=' && i + 1 < source.size() && source[i + 1] == '=') {
-      tokens.push_back({TokenKind::EqEq, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::EqEq, start_line, start_col));
       advance();
       advance();
       continue;
     }
     if (source[i] == '=') {
-      tokens.push_back({TokenKind::Equals, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Equals, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '!' && i + 1 < source.size() && source[i + 1] == '=') {
-      tokens.push_back({TokenKind::Ne, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Ne, start_line, start_col));
       advance();
       advance();
       continue;
     }
     if (source[i] == '<' && i + 1 < source.size() && source[i + 1] == '=') {
-      tokens.push_back({TokenKind::Le, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Le, start_line, start_col));
       advance();
       advance();
       continue;
     }
     if (source[i] == '<') {
-      tokens.push_back({TokenKind::Lt, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Lt, start_line, start_col));
       advance();
       continue;
     }
     if (source[i] == '>' && i + 1 < source.size() && source[i + 1] == '=') {
-      tokens.push_back({TokenKind::Ge, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Ge, start_line, start_col));
       advance();
       advance();
       continue;
     }
     if (source[i] == '>') {
-      tokens.push_back({TokenKind::Gt, 0, 0.0, {}, {}, start_line, start_col});
+      tokens.push_back(punct(TokenKind::Gt, start_line, start_col));
       advance();
       continue;
     }
@@ -273,7 +316,7 @@ std::vector<Token> lex(const std::string& source) {
     advance();
   }
 
-  tokens.push_back({TokenKind::Eof, 0, 0.0, {}, {}, line, column});
+  tokens.push_back(punct(TokenKind::Eof, line, column));
   return tokens;
 }
 
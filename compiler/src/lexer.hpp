@@ -3,11 +3,12 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace fusion {
 
-enum class TokenKind {
+enum class TokenKind : uint8_t {
   Eof,
   IntLiteral,
   FloatLiteral,
@@ -63,17 +64,23 @@ enum class TokenKind {
   Ge,     // >=
 };
 
+/* Packed largest-first so sequential token scans touch fewer cache lines:
+ * the literal value fields share a union (a token is never both an int and a
+ * float literal), kind is one byte, and positions are 32-bit like the
+ * source positions on Expr. */
 struct Token {
-  TokenKind kind = TokenKind::Eof;
-  int64_t int_value = 0;
-  double float_value = 0.0;
   std::string str_value;  // for StringLiteral content (unescaped)
   std::string ident;
-  size_t line = 0;
-  size_t column = 0;
+  union {
+    int64_t int_value = 0;
+    double float_value;
+  };
+  uint32_t line = 0;
+  uint32_t column = 0;
+  TokenKind kind = TokenKind::Eof;
 };
 
-std::vector<Token> lex(const std::string& source);
+std::vector<Token> lex(std::string_view source);
 
 }  // namespace fusion
 
@@ -15,6 +15,23 @@
 
 namespace fusion {
 
+static ImportSourceResolver g_import_source_resolver;
+
+void set_import_source_resolver(ImportSourceResolver resolver) {
+  g_import_source_resolver = std::move(resolver);
+}
+
+/* Reads a library source, consulting the test resolver first. */
+static bool load_source(const std::string& path, std::string* out) {
+  if (g_import_source_resolver && g_import_source_resolver(path, out)) return true;
+  std::ifstream f(path);
+  if (!f) return false;
+  std::stringstream buf;
+  buf << f.rdbuf();
+  *out = buf.str();
+  return true;
+}
+
 static std::string get_dir(const std::string& path) {
   size_t slash = path.find_last_of("/\\");
   if (slash == std::string::npos) return ".";
@@ -32,6 +49,10 @@ static std::string get_stdlib_dir() {
 }
 
 static bool file_exists(const std::string& path) {
+  if (g_import_source_resolver) {
+    std::string ignored;
+    if (g_import_source_resolver(path, &ignored)) return true;
+  }
   std::ifstream f(path);
   return f.good();
 }
@@ -209,11 +230,9 @@ static std::string load_and_build_postorder(
   if (cache.count(canon)) {
     prog = cache[canon].get();
   } else {
-    std::ifstream f(file_path);
-    if (!f) return "cannot open '" + file_path + "' (resolved from import)";
-    std::stringstream buf;
-    buf << f.rdbuf();
-    std::string source = buf.str();
+    std::string source;
+    if (!load_source(file_path, &source))
+      return "cannot open '" + file_path + "' (resolved from import)";
     auto tokens = lex(source);
     auto pr = parse(tokens);
     if (!pr.ok()) return "parse error in '" + file_path + "': " + pr.error.message;
@@ -1,6 +1,7 @@
 #ifndef FUSION_MULTIFILE_HPP
 #define FUSION_MULTIFILE_HPP
 
+#include <functional>
 #include <string>
 
 namespace fusion {
@@ -11,6 +12,13 @@ struct Program;
  *  Returns empty string on success, or an error message. */
 std::string resolve_imports_and_merge(const std::string& main_path, Program* main_prog);
 
+/** When set, import resolution asks the callback for library sources before the
+ *  filesystem (return false to fall through to disk, e.g. for the stdlib).
+ *  Lets tests supply in-memory libraries without temp files; pass nullptr to
+ *  restore plain filesystem loading. */
+using ImportSourceResolver = std::function<bool(const std::string& path, std::string* out_source)>;
+void set_import_source_resolver(ImportSourceResolver resolver);
+
 }  // namespace fusion
 
 #endif
@@ -1017,4 +1017,15 @@ ParseResult parse(const std::vector<Token>& tokens) {
   return r;
 }
 
+ExprPtr parse_single_expr(const std::vector<Token>& tokens) {
+  g_call_sites.clear();
+  size_t i = 0;
+  ExprPtr expr = parse_expr(tokens, i);
+  if (!expr) return nullptr;
+  if (!at_eof(tokens, i) && tokens[i].kind == TokenKind::Semicolon) i++;
+  if (!at_eof(tokens, i) && tokens[i].kind != TokenKind::Eof) return nullptr;
+  g_call_sites.clear();
+  return expr;
+}
+
 }  // namespace fusion
@@ -39,6 +39,11 @@ struct ParseResult {
 
 ParseResult parse(const std::vector<Token>& tokens);
 
+/** Parses a single expression (REPL-style input) without building a Program.
+ *  Returns nullptr if the tokens are not exactly one expression, optionally
+ *  followed by a semicolon. Call-site spans are not collected in this mode. */
+ExprPtr parse_single_expr(const std::vector<Token>& tokens);
+
 }  // namespace fusion
 
 #endif
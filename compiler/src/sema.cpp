@@ -1,8 +1,18 @@
 #include "ast.hpp"
 #include "layout.hpp"
 #include "sema.hpp"
+#include <array>
+#include <atomic>
+#include <thread>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
+
+/* Static branch hints for the few dispatch-level branches the compiler cannot
+ * infer on its own; error arms are already steered cold by the noinline
+ * __attribute__((cold)) set_error they call. */
+#define FUSION_LIKELY(x) __builtin_expect(!!(x), 1)
+#define FUSION_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -24,49 +34,397 @@ enum class PtrBase {
   Unknown,
 };
 
-static FnPtrSig fn_def_to_sig(const FnDef& def) {
-  FnPtrSig sig;
-  for (const auto& p : def.params) sig.params.push_back(p.second);
-  sig.result = def.return_type;
-  return sig;
-}
+/* Vector-backed map for per-scope symbol tables. Scopes typically hold only a
+ * handful of names; at those sizes a linear scan over contiguous pairs beats
+ * an unordered_map probe plus its per-node heap allocations.
+ *
+ * Keys are string_views into identifier storage owned by the AST, which
+ * outlives every SemaContext — the Program is, in effect, the arena. Every
+ * insert site passes an AST-owned string (binding/param/let names), so no
+ * per-entry key copy is ever made. Do not insert with a temporary key. */
+template <typename V>
+class SmallScopeMap {
+ public:
+  V* find(std::string_view key) {
+    for (size_t i = 0; i < keys_.size(); ++i)
+      if (keys_[i] == key) return &vals_[i];
+    return nullptr;
+  }
+  const V* find(std::string_view key) const {
+    return const_cast<SmallScopeMap*>(this)->find(key);
+  }
+  bool count(std::string_view key) const { return find(key) != nullptr; }
+  /* Single-scan insert for the declaration paths: returns the new slot, or
+   * nullptr when the name is already bound in this scope (duplicate). */
+  V* try_emplace(std::string_view key) {
+    if (find(key)) return nullptr;
+    keys_.push_back(key);
+    vals_.emplace_back();
+    return &vals_.back();
+  }
+  V& operator[](std::string_view key) {
+    if (V* v = find(key)) return *v;
+    keys_.push_back(key);
+    vals_.emplace_back();
+    return vals_.back();
+  }
+  void reserve(size_t n) {
+    keys_.reserve(n);
+    vals_.reserve(n);
+  }
+  void clear() {
+    keys_.clear();
+    vals_.clear();
+  }
+
+ private:
+  /* Keys and values in separate arrays so a lookup scans only the dense
+   * key views and never steps over value payloads (FnPtrSig, std::string);
+   * misses — the common case when walking outer scopes — stay in one or
+   * two cache lines. */
+  std::vector<std::string_view> keys_;
+  std::vector<V> vals_;
+};
+
+/* Insert-only open-addressing hash table keyed by string. Lookups hash a
+ * string_view (FNV-1a) so callers never build a temporary key, and slots sit
+ * in one flat array instead of per-node heap buckets. This fills the role
+ * llvm::StringMap plays elsewhere; the frontend stays LLVM-free for the LSP
+ * build, so it cannot use the real thing. */
+template <typename V>
+class StringTable {
+ public:
+  void reserve(size_t n) {
+    if (n) rehash(next_pow2(n * 2));
+  }
+
+  V* find(std::string_view key) {
+    if (slots_.empty()) return nullptr;
+    const size_t h = hash(key);
+    const uint8_t tag = slot_tag(h);
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+      Slot& s = slots_[i];
+      if (!s.used) return nullptr;
+      /* Tag-byte prefilter (hash top bits): rejects almost every colliding
+       * probe with one byte compare before touching the key string. */
+      if (s.tag == tag && s.key == key) return &s.value;
+    }
+  }
+  const V* find(std::string_view key) const {
+    return const_cast<StringTable*>(this)->find(key);
+  }
+  bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+  V& operator[](std::string_view key) {
+    if (slots_.empty() || (size_ + 1) * 4 > slots_.size() * 3)
+      rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    const size_t h = hash(key);
+    const uint8_t tag = slot_tag(h);
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+      Slot& s = slots_[i];
+      if (!s.used) {
+        s.used = true;
+        s.tag = tag;
+        s.key.assign(key.data(), key.size());
+        ++size_;
+        return s.value;
+      }
+      if (s.tag == tag && s.key == key) return s.value;
+    }
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    std::string key;
+    V value{};
+    uint8_t tag = 0;
+    bool used = false;
+  };
+
+  /* Top hash bits; the low bits pick the slot, so these stay independent. */
+  static uint8_t slot_tag(size_t h) { return static_cast<uint8_t>(h >> 56); }
+
+  static size_t hash(std::string_view key) {
+    size_t h = 1469598103934665603ull;
+    for (unsigned char c : key) {
+      h ^= c;
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+  static size_t next_pow2(size_t n) {
+    size_t p = 16;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  void rehash(size_t cap) {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.resize(cap);
+    size_ = 0;
+    for (Slot& s : old) {
+      if (!s.used) continue;
+      V& v = (*this)[s.key];
+      v = std::move(s.value);
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+/* Interns identifier strings to dense uint32_t ids (first id is 1; 0 means
+ * "absent"). Built once in check() from the program's function names, then
+ * read-only while bodies are checked — lookups from the parallel phase never
+ * mutate it. With ids cached on the nodes (Expr::sym), repeated name lookups
+ * collapse to a vector index instead of a string hash.
+ *
+ * Only callable names get ids. Locals and field names deliberately stay
+ * strings: scope frames hold a handful of entries scanned as string_views
+ * into AST storage, and field lookups go through the per-struct index, so a
+ * program-wide id space for them would add a parser/sema coupling without
+ * removing any hash from a hot path. */
+class SymbolPool {
+ public:
+  void reserve(size_t n) { ids_.reserve(n); }
+  uint32_t intern(std::string_view name) {
+    uint32_t& id = ids_[name];
+    if (id == 0) id = ++count_;
+    return id;
+  }
+  uint32_t lookup(std::string_view name) const {
+    const uint32_t* id = ids_.find(name);
+    return id ? *id : 0;
+  }
+  uint32_t size() const { return count_; }
 
-static FnPtrSig extern_fn_to_sig(const ExternFn& ext) {
+ private:
+  StringTable<uint32_t> ids_;
+  uint32_t count_ = 0;
+};
+
+/* Expr::sym value for "resolved, but not a known symbol". */
+constexpr uint32_t kSymUnknown = 0xFFFFFFFFu;
+
+/* Everything sema knows about a callable name, indexed by symbol id. One flat
+ * vector replaces the per-name extern/user/return-type maps. */
+struct CalleeInfo {
+  const ExternFn* ext = nullptr;
+  FnDef* user = nullptr;
+  /* Ready-made signature: params flattened out of the (name, type) pairs so
+   * argument checking walks one dense byte array, and the whole FnPtrSig can
+   * be handed out by pointer instead of rebuilt per lookup. Both entry kinds
+   * fill it, so "known callable" is just (ext || user). */
   FnPtrSig sig;
-  for (const auto& p : ext.params) sig.params.push_back(p.second);
-  sig.result = ext.return_type;
-  return sig;
-}
+
+  bool known() const { return ext != nullptr || user != nullptr; }
+};
 
 struct SemaContext {
-  std::unordered_set<std::string> lib_names;
-  std::unordered_map<std::string, ExternFn> extern_fn_by_name;
-  std::unordered_map<std::string, FnDef*> user_fn_by_name;
-  std::vector<std::unordered_map<std::string, FfiType>> var_scope_stack;
-  std::vector<std::unordered_map<std::string, FfiType>> array_element_scope_stack;
-  std::vector<std::unordered_map<std::string, FnPtrSig>> fnptr_scope_stack;
-  std::vector<std::unordered_map<std::string, AllocFlavor>> var_flavor_scope_stack;
-  std::vector<std::unordered_map<std::string, PtrBase>> var_base_scope_stack;
-  /* Ptr-to-struct tracking: variable name -> struct name it points to */
-  std::vector<std::unordered_map<std::string, std::string>> var_struct_scope_stack;
-  /* Array element struct tracking: variable name -> struct name of elements */
-  std::vector<std::unordered_map<std::string, std::string>> array_struct_scope_stack;
-  /* Ptr element type tracking: variable name -> "char", struct name, or "" */
-  std::vector<std::unordered_map<std::string, std::string>> var_ptr_element_scope_stack;
+  /* Members are ordered hot-first: the shared read-only pointers and the
+   * expected-return state are touched on nearly every node, so they share the
+   * leading cache lines; the spare-frame pools, used only at block entry and
+   * exit, sit at the back. */
+  /* Shared read-only symbol pool and per-symbol callee table; see check(). */
+  const SymbolPool* symbols = nullptr;
+  const std::vector<CalleeInfo>* callees = nullptr;
+  /* Named-type membership, prebuilt once in check() and shared read-only;
+   * flat open-addressing sets (see StringTable). */
+  const StringTable<char>* named_types = nullptr;
+  const StringTable<char>* struct_names = nullptr;
   LayoutMap* layout_map = nullptr;  // from Program::struct_defs
   Program* program = nullptr;
   SemaError* err = nullptr;
   bool has_expected_return_type = false;
   FfiType expected_return_type = FfiType::Void;
+  std::vector<SmallScopeMap<FfiType>> var_scope_stack;
+  std::vector<SmallScopeMap<FfiType>> array_element_scope_stack;
+  std::vector<SmallScopeMap<FnPtrSig>> fnptr_scope_stack;
+  std::vector<SmallScopeMap<AllocFlavor>> var_flavor_scope_stack;
+  std::vector<SmallScopeMap<PtrBase>> var_base_scope_stack;
+  /* Ptr-to-struct tracking: variable name -> struct name it points to */
+  std::vector<SmallScopeMap<std::string>> var_struct_scope_stack;
+  /* Array element struct tracking: variable name -> struct name of elements */
+  std::vector<SmallScopeMap<std::string>> array_struct_scope_stack;
+  /* Ptr element type tracking: variable name -> "char", struct name, or "" */
+  std::vector<SmallScopeMap<std::string>> var_ptr_element_scope_stack;
+  /* Retired scope frames, one pool per stack. Scope lifetimes are strictly
+   * LIFO, so a popped frame's entry storage can serve the next sibling scope;
+   * after the first pass through a function, push/pop allocate nothing. */
+  std::vector<SmallScopeMap<FfiType>> var_scope_spare;
+  std::vector<SmallScopeMap<FfiType>> array_element_scope_spare;
+  std::vector<SmallScopeMap<FnPtrSig>> fnptr_scope_spare;
+  std::vector<SmallScopeMap<AllocFlavor>> var_flavor_scope_spare;
+  std::vector<SmallScopeMap<PtrBase>> var_base_scope_spare;
+  std::vector<SmallScopeMap<std::string>> var_struct_scope_spare;
+  std::vector<SmallScopeMap<std::string>> array_struct_scope_spare;
+  std::vector<SmallScopeMap<std::string>> var_ptr_element_scope_spare;
 };
 
+/* All error-message formatting funnels through here; cold + noinline keeps the
+ * string building out of the hot checking paths. */
+template <typename... Parts>
+__attribute__((cold, noinline)) static void set_error(SemaError* err, Parts&&... parts) {
+  err->message.clear();
+  /* One sized allocation instead of growth per appended part. */
+  err->message.reserve((std::string_view(parts).size() + ...));
+  (err->message.append(parts), ...);
+}
+
+template <typename... Parts>
+static void set_error(SemaContext& ctx, Parts&&... parts) {
+  set_error(ctx.err, std::forward<Parts>(parts)...);
+}
+
+/* Callee table entry for a name carried on this node (callee for Call,
+ * var_name for VarRef), resolving and caching the symbol id on first use.
+ * Returns nullptr for names that are not known functions. */
+static const CalleeInfo* callee_info(Expr* expr, const std::string& name, const SemaContext* ctx) {
+  if (!ctx || !ctx->symbols) return nullptr;
+  if (expr->sym == 0) {
+    uint32_t id = ctx->symbols->lookup(name);
+    expr->sym = id ? id : kSymUnknown;
+  }
+  if (expr->sym == kSymUnknown) return nullptr;
+  return &(*ctx->callees)[expr->sym];
+}
+
+/* Builtin callables. check() interns kBuiltinNames into the pool first and in
+ * this order, so for ids 1..kNumBuiltins the id *is* the Builtin value and
+ * classification is a cached-id comparison — no string compares on the hot
+ * Call path. */
+enum class Builtin : uint32_t {
+  None = 0,
+  GetFuncPtr,
+  Call,
+  Print,
+  Println,
+  ReadLine,
+  ReadKey,
+  TerminalHeight,
+  TerminalWidth,
+  Flush,
+  Sleep,
+  Chr,
+  ToStr,
+  FromStr,
+  Open,
+  Close,
+  ReadLineFile,
+  StrDup,
+  StrUpper,
+  StrLower,
+  StrStrip,
+  StrContains,
+  StrFind,
+  StrSplit,
+  HttpRequest,
+  HttpStatus,
+  WriteFile,
+  WriteBytes,
+  ReadBytes,
+  EofFile,
+  LineCountFile,
+  Len,
+};
+
+constexpr const char* kBuiltinNames[] = {
+  "get_func_ptr",
+  "call",
+  "print",
+  "println",
+  "read_line",
+  "read_key",
+  "terminal_height",
+  "terminal_width",
+  "flush",
+  "sleep",
+  "chr",
+  "to_str",
+  "from_str",
+  "open",
+  "close",
+  "read_line_file",
+  "str_dup",
+  "str_upper",
+  "str_lower",
+  "str_strip",
+  "str_contains",
+  "str_find",
+  "str_split",
+  "http_request",
+  "http_status",
+  "write_file",
+  "write_bytes",
+  "read_bytes",
+  "eof_file",
+  "line_count_file",
+  "len",
+};
+constexpr uint32_t kNumBuiltins = sizeof(kBuiltinNames) / sizeof(kBuiltinNames[0]);
+
+/* Fixed return type per builtin, indexed by Builtin value (index 0 = None).
+ * Call and FromStr carry FfiType::Void here; their result depends on the call
+ * site and is resolved in type_call. Mirrors builtin_fixed_return_type()
+ * (ast.hpp) without the string hash. */
+constexpr std::array<FfiType, kNumBuiltins + 1> kBuiltinReturnType = {
+  FfiType::Void,  // None
+  FfiType::Ptr,   // get_func_ptr
+  FfiType::Void,  // call (per-site)
+  FfiType::Void,  // print
+  FfiType::Void,  // println
+  FfiType::Ptr,   // read_line
+  FfiType::I64,   // read_key
+  FfiType::I64,   // terminal_height
+  FfiType::I64,   // terminal_width
+  FfiType::Void,  // flush
+  FfiType::Void,  // sleep
+  FfiType::Ptr,   // chr
+  FfiType::Ptr,   // to_str
+  FfiType::Void,  // from_str (per-site)
+  FfiType::Ptr,   // open
+  FfiType::Void,  // close
+  FfiType::Ptr,   // read_line_file
+  FfiType::Ptr,   // str_dup
+  FfiType::Ptr,   // str_upper
+  FfiType::Ptr,   // str_lower
+  FfiType::Ptr,   // str_strip
+  FfiType::I64,   // str_contains
+  FfiType::I64,   // str_find
+  FfiType::Ptr,   // str_split
+  FfiType::Ptr,   // http_request
+  FfiType::I64,   // http_status
+  FfiType::Void,  // write_file
+  FfiType::I64,   // write_bytes
+  FfiType::I64,   // read_bytes
+  FfiType::I64,   // eof_file
+  FfiType::I64,   // line_count_file
+  FfiType::I64,   // len
+};
+
+static Builtin classify_builtin(Expr* expr, const SemaContext& ctx) {
+  if (!ctx.symbols) return Builtin::None;
+  if (expr->sym == 0) {
+    uint32_t id = ctx.symbols->lookup(expr->callee);
+    expr->sym = id ? id : kSymUnknown;
+  }
+  if (expr->sym != kSymUnknown && expr->sym <= kNumBuiltins)
+    return static_cast<Builtin>(expr->sym);
+  return Builtin::None;
+}
+
 /* Lookup variable type from innermost to outermost scope. */
 static bool var_type_lookup(SemaContext* ctx, const std::string& name, FfiType* out) {
   if (!ctx || ctx->var_scope_stack.empty()) return false;
   for (auto it = ctx->var_scope_stack.rbegin(); it != ctx->var_scope_stack.rend(); ++it) {
-    auto fit = it->find(name);
-    if (fit != it->end()) {
-      *out = fit->second;
+    if (const FfiType* t = it->find(name)) {
+      *out = *t;
       return true;
     }
   }
@@ -75,11 +433,10 @@ static bool var_type_lookup(SemaContext* ctx, const std::string& name, FfiType*
 
 namespace {
 template<typename T>
-T scope_lookup(const std::vector<std::unordered_map<std::string, T>>& stack,
+T scope_lookup(const std::vector<SmallScopeMap<T>>& stack,
                const std::string& name, const T& default_val) {
   for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
-    auto fit = it->find(name);
-    if (fit != it->end()) return fit->second;
+    if (const T* v = it->find(name)) return *v;
   }
   return default_val;
 }
@@ -122,15 +479,14 @@ static std::string array_struct_lookup(SemaContext* ctx, const std::string& name
 /* For a Call that returns ptr, return array_element_struct if the callee declares it. */
 static std::string get_call_array_element_struct(Expr* expr, SemaContext* ctx) {
   if (!expr || expr->kind != Expr::Kind::Call || !ctx) return "";
-  auto user_it = ctx->user_fn_by_name.find(expr->callee);
-  if (user_it != ctx->user_fn_by_name.end()) {
-    const FnDef& def = *user_it->second;
+  const CalleeInfo* info = callee_info(expr, expr->callee, ctx);
+  if (info && info->user) {
+    const FnDef& def = *info->user;
     if (def.return_type == FfiType::Ptr && def.return_type_name.empty() && !def.array_element_struct.empty())
       return def.array_element_struct;
   }
-  auto ext_it = ctx->extern_fn_by_name.find(expr->callee);
-  if (ext_it != ctx->extern_fn_by_name.end()) {
-    const ExternFn& ext = ext_it->second;
+  if (info && info->ext) {
+    const ExternFn& ext = *info->ext;
     if (ext.return_type == FfiType::Ptr && ext.return_type_name.empty() && !ext.array_element_struct.empty())
       return ext.array_element_struct;
   }
@@ -139,7 +495,7 @@ static std::string get_call_array_element_struct(Expr* expr, SemaContext* ctx) {
 
 /* Get the struct name that an expression points to (for field access). */
 static std::string expr_struct_name(Expr* expr, SemaContext* ctx);
-static bool is_named_type_known(const std::string& name, Program* program);
+static bool is_named_type_known(const std::string& name, const SemaContext* ctx);
 
 static bool may_outlive_function(PtrBase b) {
   return b != PtrBase::StackLocal;
@@ -153,14 +509,14 @@ static bool is_stack_ptr(AllocFlavor f) {
 static void update_var_flavor_base(SemaContext* ctx, const std::string& name, AllocFlavor f, PtrBase b) {
   if (!ctx) return;
   for (auto it = ctx->var_flavor_scope_stack.rbegin(); it != ctx->var_flavor_scope_stack.rend(); ++it) {
-    if (it->count(name)) {
-      (*it)[name] = f;
+    if (AllocFlavor* v = it->find(name)) {
+      *v = f;
       break;
     }
   }
   for (auto it = ctx->var_base_scope_stack.rbegin(); it != ctx->var_base_scope_stack.rend(); ++it) {
-    if (it->count(name)) {
-      (*it)[name] = b;
+    if (PtrBase* v = it->find(name)) {
+      *v = b;
       break;
     }
   }
@@ -177,17 +533,15 @@ static std::string expr_struct_name(Expr* expr, SemaContext* ctx) {
       if (!s.empty()) return s;
       // Fallback: param ptr[Value] etc. may be in var_ptr_element_scope but not in var_struct_scope
       s = var_ptr_element_lookup(ctx, expr->var_name);
-      if (!s.empty() && ctx->program && is_named_type_known(s, ctx->program))
+      if (!s.empty() && ctx->program && is_named_type_known(s, ctx))
         return s;
       return "";
     }
     case Expr::Kind::HeapAlloc:
     case Expr::Kind::StackAlloc:
       // Only struct names (not primitive type names)
-      if (ctx->program) {
-        for (const auto& s : ctx->program->struct_defs)
-          if (s.name == expr->var_name) return expr->var_name;
-      }
+      if (ctx->struct_names && ctx->struct_names->contains(expr->var_name))
+        return expr->var_name;
       return "";
     case Expr::Kind::Index:
       if (expr->left && expr->left->kind == Expr::Kind::VarRef)
@@ -199,12 +553,9 @@ static std::string expr_struct_name(Expr* expr, SemaContext* ctx) {
         for (const std::string& fname : fa->field_chain) {
           auto it = ctx->layout_map->find(cur);
           if (it == ctx->layout_map->end()) return "";
-          for (const auto& f : it->second.fields) {
-            if (f.first == fname) {
-              cur = f.second.struct_name;
-              if (cur.empty()) return "";
-              break;
-            }
+          if (const FieldLayout* f = it->second.find_field(fname)) {
+            cur = f->struct_name;
+            if (cur.empty()) return "";
           }
         }
         return cur;
@@ -212,9 +563,7 @@ static std::string expr_struct_name(Expr* expr, SemaContext* ctx) {
       if (expr->left && (expr->left->kind == Expr::Kind::HeapArray ||
                           expr->left->kind == Expr::Kind::StackArray)) {
         const std::string& tn = expr->left->var_name;
-        if (ctx->program)
-          for (const auto& s : ctx->program->struct_defs)
-            if (s.name == tn) return tn;
+        if (ctx->struct_names && ctx->struct_names->contains(tn)) return tn;
       }
       return "";
     case Expr::Kind::FieldAccess: {
@@ -225,55 +574,42 @@ static std::string expr_struct_name(Expr* expr, SemaContext* ctx) {
       for (size_t fi = 0; fi + 1 < expr->field_chain.size(); ++fi) {
         auto it = ctx->layout_map->find(cur);
         if (it == ctx->layout_map->end()) return "";
-        bool found = false;
-        for (const auto& f : it->second.fields) {
-          if (f.first == expr->field_chain[fi]) {
-            cur = f.second.struct_name;
-            found = true;
-            break;
-          }
-        }
-        if (!found || cur.empty()) return "";
+        const FieldLayout* f = it->second.find_field(expr->field_chain[fi]);
+        if (!f) return "";
+        cur = f->struct_name;
+        if (cur.empty()) return "";
       }
       // Last field: return its struct_name if embedded, else ""
       auto it = ctx->layout_map->find(cur);
       if (it == ctx->layout_map->end()) return "";
-      const std::string& last_field = expr->field_chain.back();
-      for (const auto& f : it->second.fields) {
-        if (f.first == last_field) return f.second.struct_name;
-      }
+      if (const FieldLayout* f = it->second.find_field(expr->field_chain.back()))
+        return f->struct_name;
       return "";
     }
     case Expr::Kind::Cast:
-      if (ctx->program) {
-        for (const auto& s : ctx->program->struct_defs)
-          if (s.name == expr->var_name) return expr->var_name;
-      }
+      if (ctx->struct_names && ctx->struct_names->contains(expr->var_name))
+        return expr->var_name;
       return "";
     case Expr::Kind::Call: {
       if (!ctx) return "";
       auto is_known_struct = [&](const std::string& name) -> bool {
-        if (!ctx->program || name.empty()) return false;
-        for (const auto& s : ctx->program->struct_defs)
-          if (s.name == name) return true;
-        return false;
+        return !name.empty() && ctx->struct_names && ctx->struct_names->contains(name);
       };
-      auto user_it = ctx->user_fn_by_name.find(expr->callee);
-      if (user_it != ctx->user_fn_by_name.end()) {
-        if (!user_it->second->return_type_name.empty())
-          return user_it->second->return_type_name;
+      const CalleeInfo* info = callee_info(expr, expr->callee, ctx);
+      if (info && info->user) {
+        const FnDef& def = *info->user;
+        if (!def.return_type_name.empty())
+          return def.return_type_name;
         // -> ptr[T] return type: T is in array_element_struct; use it for struct field tracking
-        if (user_it->second->return_type == FfiType::Ptr &&
-            is_known_struct(user_it->second->array_element_struct))
-          return user_it->second->array_element_struct;
-      }
-      auto ext_it = ctx->extern_fn_by_name.find(expr->callee);
-      if (ext_it != ctx->extern_fn_by_name.end()) {
-        if (!ext_it->second.return_type_name.empty())
-          return ext_it->second.return_type_name;
-        if (ext_it->second.return_type == FfiType::Ptr &&
-            is_known_struct(ext_it->second.array_element_struct))
-          return ext_it->second.array_element_struct;
+        if (def.return_type == FfiType::Ptr && is_known_struct(def.array_element_struct))
+          return def.array_element_struct;
+      }
+      if (info && info->ext) {
+        const ExternFn& ext = *info->ext;
+        if (!ext.return_type_name.empty())
+          return ext.return_type_name;
+        if (ext.return_type == FfiType::Ptr && is_known_struct(ext.array_element_struct))
+          return ext.array_element_struct;
       }
       return "";
     }
@@ -310,21 +646,45 @@ static PtrBase expr_base(Expr* expr, SemaContext* ctx) {
   }
 }
 
-static bool is_alloc_type(const std::string& name, Program* program) {
-  if (name == "i8" || name == "i32" || name == "i64" || name == "f32" || name == "f64" || name == "ptr")
+/* Packs a name of up to 4 chars plus its length into a u64 switch key, so the
+ * builtin type-name checks below compile to a jump table instead of a chain of
+ * string compares. Longer names cannot collide: the length byte differs. */
+static constexpr uint64_t pack_type_name(const char* s, size_t n) {
+  uint64_t key = uint64_t(n) << 32;
+  for (size_t i = 0; i < n && i < 4; ++i)
+    key |= uint64_t(uint8_t(s[i])) << (8 * i);
+  return key;
+}
+
+static uint64_t pack_type_name(const std::string& name) {
+  return pack_type_name(name.data(), name.size());
+}
+
+/* Builtin primitive names valid for stack/heap allocation. */
+static bool is_primitive_alloc_name(const std::string& name) {
+  switch (pack_type_name(name)) {
+    case pack_type_name("i8", 2):
+    case pack_type_name("i32", 3):
+    case pack_type_name("i64", 3):
+    case pack_type_name("f32", 3):
+    case pack_type_name("f64", 3):
+    case pack_type_name("ptr", 3):
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool is_alloc_type(const std::string& name, const SemaContext* ctx) {
+  if (is_primitive_alloc_name(name))
     return true;
-  if (name.size() > 5 && name.substr(0,4) == "ptr[" && name.back() == ']') {
-    const std::string inner = name.substr(4, name.size()-5);
+  if (!ctx || !ctx->struct_names) return false;
+  if (name.size() > 5 && name.compare(0, 4, "ptr[") == 0 && name.back() == ']') {
+    const std::string_view inner(name.data() + 4, name.size() - 5);
     if (inner == "char") return true;  // ptr[char] = array of string pointers
-    if (program)
-      for (const auto& s : program->struct_defs)
-        if (s.name == inner) return true;
-    return false;
+    return ctx->struct_names->contains(inner);
   }
-  if (program)
-    for (const auto& s : program->struct_defs)
-      if (s.name == name) return true;
-  return false;
+  return ctx->struct_names->contains(name);
 }
 
 /* Returns element type if expr is an array (ptr from stack_array/heap_array or VarRef to such); otherwise FfiType::Void. */
@@ -338,14 +698,11 @@ static FfiType get_array_element_type(Expr* expr, SemaContext* ctx) {
     if (cur.empty()) return FfiType::Void;
     auto it = ctx->layout_map->find(cur);
     if (it == ctx->layout_map->end()) return FfiType::Void;
-    for (const auto& f : it->second.fields) {
-      if (f.first == expr->field_chain[0]) {
-        FfiType ft = f.second.type;
-        /* Layout may mark ptr[Struct] as Void (embedded); indexing yields pointer. */
-        if (ft == FfiType::Void && !f.second.struct_name.empty())
-          return FfiType::Ptr;
-        return ft;
-      }
+    if (const FieldLayout* f = it->second.find_field(expr->field_chain[0])) {
+      /* Layout may mark ptr[Struct] as Void (embedded); indexing yields pointer. */
+      if (f->type == FfiType::Void && !f->struct_name.empty())
+        return FfiType::Ptr;
+      return f->type;
     }
     return FfiType::Void;
   }
@@ -362,924 +719,1228 @@ static FfiType get_array_element_type(Expr* expr, SemaContext* ctx) {
   return FfiType::Void;
 }
 
-/* Lookup function pointer signature for an expression. Returns true if known. */
-static bool lookup_fnptr_sig(SemaContext* ctx, Expr* expr, FnPtrSig* out) {
-  if (!ctx || !expr || !out) return false;
+/* Lookup function pointer signature for an expression. Returns a pointer to
+ * signature storage that outlives the caller's use (a scope-frame entry or a
+ * CalleeInfo built once in check()); nullptr when unknown. No copies. */
+static const FnPtrSig* lookup_fnptr_sig(SemaContext* ctx, Expr* expr) {
+  if (!ctx || !expr) return nullptr;
   if (expr->kind == Expr::Kind::VarRef) {
     for (auto it = ctx->fnptr_scope_stack.rbegin(); it != ctx->fnptr_scope_stack.rend(); ++it) {
-      auto fit = it->find(expr->var_name);
-      if (fit != it->end()) {
-        *out = fit->second;
-        return true;
-      }
-    }
-    auto user_it = ctx->user_fn_by_name.find(expr->var_name);
-    if (user_it != ctx->user_fn_by_name.end()) {
-      *out = fn_def_to_sig(*user_it->second);
-      return true;
-    }
-    auto ext_it = ctx->extern_fn_by_name.find(expr->var_name);
-    if (ext_it != ctx->extern_fn_by_name.end()) {
-      *out = extern_fn_to_sig(ext_it->second);
-      return true;
+      if (const FnPtrSig* sig = it->find(expr->var_name)) return sig;
     }
-    return false;
+    const CalleeInfo* info = callee_info(expr, expr->var_name, ctx);
+    if (info && (info->user || info->ext)) return &info->sig;
+    return nullptr;
   }
-  if (expr->kind == Expr::Kind::Call && expr->callee == "get_func_ptr" &&
+  if (expr->kind == Expr::Kind::Call && classify_builtin(expr, *ctx) == Builtin::GetFuncPtr &&
       expr->args.size() == 1 && expr->args[0]->kind == Expr::Kind::VarRef) {
-    const std::string& fn_name = expr->args[0]->var_name;
-    auto user_it = ctx->user_fn_by_name.find(fn_name);
-    if (user_it != ctx->user_fn_by_name.end()) {
-      *out = fn_def_to_sig(*user_it->second);
-      return true;
-    }
-    auto ext_it = ctx->extern_fn_by_name.find(fn_name);
-    if (ext_it != ctx->extern_fn_by_name.end()) {
-      *out = extern_fn_to_sig(ext_it->second);
-      return true;
-    }
-    return false;
+    const CalleeInfo* info = callee_info(expr->args[0].get(), expr->args[0]->var_name, ctx);
+    if (info && (info->user || info->ext)) return &info->sig;
+    return nullptr;
   }
-  return false;
+  return nullptr;
 }
 
 static bool check_expr(Expr* expr, SemaContext& ctx);
 
+/* Fused validate + type: checks the expression and, when it is valid, types it
+ * in the same call so callers do not repeat the two-step pattern. */
+struct CheckedType {
+  bool ok;
+  FfiType ty;
+};
+
+/* Overload-set helper for std::visit over TopLevelItem. */
+template <typename... Fs>
+struct overloaded : Fs... {
+  using Fs::operator()...;
+};
+template <typename... Fs>
+overloaded(Fs...) -> overloaded<Fs...>;
+
+static CheckedType check_and_type(Expr* expr, SemaContext& ctx) {
+  if (FUSION_UNLIKELY(!check_expr(expr, ctx))) return {false, FfiType::Void};
+  return {true, expr_type(expr, &ctx)};
+}
+
 /* Validates that a builtin call has exactly one ptr argument. Sets ctx.err on failure. */
 static bool check_one_ptr_arg(Expr* expr, const char* fname, const char* arg_desc,
                                SemaContext& ctx) {
   if (expr->args.size() != 1) {
-    ctx.err->message = std::string(fname) + " expects one argument (" + arg_desc + ")";
+    set_error(ctx, fname, " expects one argument (", arg_desc, ")");
     return false;
   }
-  if (!check_expr(expr->args[0].get(), ctx)) return false;
-  if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
-    ctx.err->message = std::string(fname) + " expects pointer argument";
+  CheckedType arg = check_and_type(expr->args[0].get(), ctx);
+  if (!arg.ok) return false;
+  if (arg.ty != FfiType::Ptr) {
+    set_error(ctx, fname, " expects pointer argument");
     return false;
   }
   return true;
 }
 
-static bool check_expr(Expr* expr, SemaContext& ctx) {
-  if (!expr) return false;
-  if (expr->line > 0) {
-    ctx.err->line = expr->line;
-    ctx.err->column = expr->column;
-  }
-  switch (expr->kind) {
-    case Expr::Kind::IntLiteral:
-      return true;
-    case Expr::Kind::FloatLiteral:
-      return true;
-    case Expr::Kind::StringLiteral:
-      expr->inferred_ptr_element = "char";
+/* Per-kind checkers for check_expr; dispatched through kCheckTable below. */
+static bool check_int_literal(Expr* expr, SemaContext& ctx) {
+  return true;
+}
+
+static bool check_float_literal(Expr* expr, SemaContext& ctx) {
+  return true;
+}
+
+static bool check_string_literal(Expr* expr, SemaContext& ctx) {
+  expr->inferred_ptr_element = "char";
+  return true;
+}
+
+/* Type-class bitmasks over FfiType: bit i is set when FfiType(i) belongs to
+ * the class, so membership is ((mask >> (int)t) & 1) with no branches. */
+constexpr uint32_t kArithNumericMask =
+    (1u << (int)FfiType::I64) | (1u << (int)FfiType::I32) | (1u << (int)FfiType::F64);
+constexpr uint32_t kCompareNumericMask =
+    (1u << (int)FfiType::I64) | (1u << (int)FfiType::F64);
+constexpr uint32_t kPrintableMask =
+    kCompareNumericMask | (1u << (int)FfiType::Ptr);
+constexpr uint32_t kCastNumericMask =
+    (1u << (int)FfiType::I8) | (1u << (int)FfiType::I32) | (1u << (int)FfiType::I64) |
+    (1u << (int)FfiType::F32) | (1u << (int)FfiType::F64);
+
+static bool both_in_class(uint32_t mask, FfiType l, FfiType r) {
+  return ((mask >> (int)l) & (mask >> (int)r) & 1u) != 0;
+}
+
+/* Numeric promotion for a BinaryOp node as a lookup table over both operand
+ * types: one load, no compares. FfiType mirrors rt_ffi_type_kind_t, so it
+ * cannot be renumbered into 2 bits; 3 bits per operand gives a 64-entry table
+ * that still fits in one cache line. */
+constexpr std::array<FfiType, 64> make_binop_result_table() {
+  std::array<FfiType, 64> t{};
+  for (int l = 0; l < 8; ++l)
+    for (int r = 0; r < 8; ++r)
+      t[(l << 3) | r] = (l == (int)FfiType::F64 || r == (int)FfiType::F64)
+                            ? FfiType::F64
+                            : FfiType::I64;
+  return t;
+}
+constexpr std::array<FfiType, 64> kBinopResult = make_binop_result_table();
+
+/* Store/argument compatibility as 64-bit masks with one bit per
+ * (dst << 3) | src pair — same indexing as kBinopResult — so the repeated
+ * multi-term boolean chains collapse to a single shift-and-test. */
+constexpr uint64_t compat_pair(FfiType dst, FfiType src) {
+  return uint64_t{1} << (((int)dst << 3) | (int)src);
+}
+constexpr uint64_t make_identity_compat() {
+  uint64_t m = 0;
+  for (int t = 0; t < 8; ++t) m |= uint64_t{1} << ((t << 3) | t);
+  return m;
+}
+/* Plain assignment and store_field: same type, or ptr<->i64. */
+constexpr uint64_t kAssignCompat = make_identity_compat() |
+    compat_pair(FfiType::Ptr, FfiType::I64) | compat_pair(FfiType::I64, FfiType::Ptr);
+/* Array-element stores additionally accept i64 values into i8 elements. */
+constexpr uint64_t kElemAssignCompat =
+    kAssignCompat | compat_pair(FfiType::I8, FfiType::I64);
+/* Field stores coerce numerics both ways on top of the base relation. */
+constexpr uint64_t kFieldAssignCompat = kAssignCompat |
+    compat_pair(FfiType::F64, FfiType::I64) | compat_pair(FfiType::I64, FfiType::F64);
+/* Indirect-call arguments: int/float coercion plus ptr<->i64. */
+constexpr uint64_t kIndirectArgCompat = make_identity_compat() |
+    compat_pair(FfiType::F64, FfiType::I64) | compat_pair(FfiType::F32, FfiType::I64) |
+    compat_pair(FfiType::I64, FfiType::F64) |
+    compat_pair(FfiType::Ptr, FfiType::I64) | compat_pair(FfiType::I64, FfiType::Ptr);
+
+static bool compat_ok(uint64_t mask, FfiType dst, FfiType src) {
+  return ((mask >> (((int)dst << 3) | (int)src)) & 1) != 0;
+}
+
+/* Result type of one BinaryOp node given already-computed operand types. */
+static FfiType binary_result_type(BinOp op, FfiType l, FfiType r) {
+  if (l == FfiType::Ptr && r == FfiType::Ptr && op == BinOp::Add)
+    return FfiType::Ptr;
+  return kBinopResult[((int)l << 3) | (int)r];
+}
+
+/* Op-rule check for one BinaryOp node; operand types are passed in. */
+static bool check_binary_op_node(Expr* expr, FfiType l, FfiType r, SemaContext& ctx) {
+  bool both_numeric = both_in_class(kArithNumericMask, l, r);
+  bool both_ptr = (l == FfiType::Ptr && r == FfiType::Ptr);
+  if (expr->bin_op == BinOp::Add) {
+    if (both_ptr) {
+      if (!expr->left->inferred_ptr_element.empty() &&
+          expr->left->inferred_ptr_element == expr->right->inferred_ptr_element)
+        expr->inferred_ptr_element = expr->left->inferred_ptr_element;
       return true;
-    case Expr::Kind::BinaryOp: {
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (!check_expr(expr->right.get(), ctx)) return false;
-      FfiType l = expr_type(expr->left.get(), &ctx);
-      FfiType r = expr_type(expr->right.get(), &ctx);
-      bool both_numeric = (l == FfiType::I64 || l == FfiType::I32 || l == FfiType::F64) && (r == FfiType::I64 || r == FfiType::I32 || r == FfiType::F64);
-      bool both_ptr = (l == FfiType::Ptr && r == FfiType::Ptr);
-      if (expr->bin_op == BinOp::Add) {
-        if (both_ptr) {
-          if (!expr->left->inferred_ptr_element.empty() &&
-              expr->left->inferred_ptr_element == expr->right->inferred_ptr_element)
-            expr->inferred_ptr_element = expr->left->inferred_ptr_element;
-          return true;
-        }
-        if (both_numeric) return true;
-        if (l == FfiType::Ptr || r == FfiType::Ptr) {
-          ctx.err->message = "operator +: strings (pointers) can only be added to strings";
-          return false;
-        }
-        ctx.err->message = "operator +: operands must be numbers or both strings";
+    }
+    if (both_numeric) return true;
+    if (l == FfiType::Ptr || r == FfiType::Ptr) {
+      set_error(ctx, "operator +: strings (pointers) can only be added to strings");
+      return false;
+    }
+    set_error(ctx, "operator +: operands must be numbers or both strings");
+    return false;
+  }
+  /* Sub, Mul, Div: require numeric */
+  if (!both_numeric) {
+    set_error(ctx, "operator - (or * or /): operands must be numbers");
+    return false;
+  }
+  return true;
+}
+
+/* Parsed chains (a + b + c + ...) lean left; walk the left spine with an
+ * explicit stack so long chains cannot overflow the C++ call stack. */
+static bool check_binary_op(Expr* expr, SemaContext& ctx) {
+  /* The spine buffer is thread-local and reused, so only the first deep chain
+   * allocates. Checking a right subtree can re-enter this function (nested
+   * parenthesized ops), so each activation works on its own [base, end) slice
+   * by index — indices stay valid if an inner call grows the buffer. */
+  static thread_local std::vector<Expr*> spine;
+  if (spine.capacity() == 0) spine.reserve(64);
+  const size_t base = spine.size();
+  Expr* n = expr;
+  while (n->kind == Expr::Kind::BinaryOp) {
+    /* Right subtrees are visited in the fold below; start pulling them in now.
+     * Nodes are scattered across the heap, so this hides part of the miss. */
+    if (n->right) __builtin_prefetch(n->right.get(), 0, 0);
+    spine.push_back(n);
+    n = n->left.get();
+  }
+  bool ok = check_expr(n, ctx);
+  FfiType l = ok ? expr_type(n, &ctx) : FfiType::Void;
+  for (size_t i = spine.size(); ok && i > base; --i) {
+    Expr* node = spine[i - 1];
+    CheckedType ct = check_and_type(node->right.get(), ctx);
+    if (!ct.ok) { ok = false; break; }
+    FfiType r = ct.ty;
+    if (node->line > 0) {
+      ctx.err->line = node->line;
+      ctx.err->column = node->column;
+    }
+    if (!check_binary_op_node(node, l, r, ctx)) { ok = false; break; }
+    l = binary_result_type(node->bin_op, l, r);
+  }
+  spine.resize(base);
+  return ok;
+}
+
+static bool check_call(Expr* expr, SemaContext& ctx) {
+  switch (classify_builtin(expr, ctx)) {
+    case Builtin::GetFuncPtr: {
+      if (expr->args.size() != 1) {
+        set_error(ctx, "get_func_ptr expects exactly one argument");
+        return false;
+      }
+      if (expr->args[0]->kind != Expr::Kind::VarRef) {
+        set_error(ctx, "get_func_ptr argument must be a function name");
         return false;
       }
-      /* Sub, Mul, Div: require numeric */
-      if (!both_numeric) {
-        ctx.err->message = "operator - (or * or /): operands must be numbers";
+      const std::string& fn_name = expr->args[0]->var_name;
+      const CalleeInfo* info = callee_info(expr->args[0].get(), fn_name, &ctx);
+      if (!info || (!info->user && !info->ext)) {
+        set_error(ctx, "get_func_ptr: unknown function '", fn_name, "'");
         return false;
       }
       return true;
     }
-    case Expr::Kind::Call: {
-      if (expr->callee == "get_func_ptr") {
-        if (expr->args.size() != 1) {
-          ctx.err->message = "get_func_ptr expects exactly one argument";
-          return false;
-        }
-        if (expr->args[0]->kind != Expr::Kind::VarRef) {
-          ctx.err->message = "get_func_ptr argument must be a function name";
-          return false;
-        }
-        const std::string& fn_name = expr->args[0]->var_name;
-        auto user_it = ctx.user_fn_by_name.find(fn_name);
-        auto ext_it = ctx.extern_fn_by_name.find(fn_name);
-        if (user_it == ctx.user_fn_by_name.end() && ext_it == ctx.extern_fn_by_name.end()) {
-          ctx.err->message = "get_func_ptr: unknown function '" + fn_name + "'";
-          return false;
-        }
-        return true;
+    case Builtin::Call: {
+      if (expr->args.size() < 1) {
+        set_error(ctx, "call expects at least a function pointer argument");
+        return false;
       }
-      if (expr->callee == "call") {
-        if (expr->args.size() < 1) {
-          ctx.err->message = "call expects at least a function pointer argument";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = "call first argument must be a function pointer";
-          return false;
-        }
-        FnPtrSig sig;
-        if (!lookup_fnptr_sig(&ctx, expr->args[0].get(), &sig)) {
-          /* First arg is Ptr but target unknown (e.g. load_field): infer signature from call site. */
-          for (size_t k = 1; k < expr->args.size(); ++k) {
-            if (!check_expr(expr->args[k].get(), ctx)) return false;
-          }
-          sig.params.clear();
-          for (size_t k = 1; k < expr->args.size(); ++k)
-            sig.params.push_back(expr_type(expr->args[k].get(), &ctx));
-          sig.result = ctx.has_expected_return_type ? ctx.expected_return_type : FfiType::Void;
-          expr->inferred_call_param_types = sig.params;
-          expr->inferred_call_result_type = sig.result;
-        }
-        if (expr->args.size() - 1 != sig.params.size()) {
-          ctx.err->message = "call: wrong number of arguments for function pointer";
-          return false;
-        }
-        for (size_t j = 0; j < sig.params.size(); ++j) {
-          if (!check_expr(expr->args[j + 1].get(), ctx)) return false;
-          FfiType arg_ty = expr_type(expr->args[j + 1].get(), &ctx);
-          if (arg_ty == FfiType::Ptr && is_stack_ptr(expr_flavor(expr->args[j + 1].get(), &ctx))) {
-            ctx.err->message = "cannot pass stack pointer to indirect call (unknown callee)";
-            return false;
-          }
-          FfiType want = sig.params[j];
-          bool compat = (arg_ty == want) ||
-            (arg_ty == FfiType::I64 && (want == FfiType::F64 || want == FfiType::F32)) ||
-            (arg_ty == FfiType::F64 && want == FfiType::I64) ||
-            (arg_ty == FfiType::Ptr && want == FfiType::I64) ||
-            (arg_ty == FfiType::I64 && want == FfiType::Ptr);
-          if (!compat) {
-            ctx.err->message = "call: argument type mismatch for function pointer";
-            return false;
-          }
-        }
-        return true;
+      CheckedType ct = check_and_type(expr->args[0].get(), ctx);
+      if (!ct.ok) return false;
+      if (ct.ty != FfiType::Ptr) {
+        set_error(ctx, "call first argument must be a function pointer");
+        return false;
       }
-      if (expr->callee == "print" || expr->callee == "println") {
-        if (expr->args.size() != 1 && expr->args.size() != 2) {
-          ctx.err->message = expr->callee + " expects 1 or 2 arguments";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        FfiType arg_ty = expr_type(expr->args[0].get(), &ctx);
-        if (arg_ty != FfiType::I64 && arg_ty != FfiType::F64 && arg_ty != FfiType::Ptr) {
-          ctx.err->message = expr->callee + " expects i64, f64, or pointer argument";
-          return false;
-        }
-        if (expr->args.size() == 2) {
-          if (!check_expr(expr->args[1].get(), ctx)) return false;
-          if (expr_type(expr->args[1].get(), &ctx) != FfiType::I64) {
-            ctx.err->message = expr->callee + " stream argument must be i64";
-            return false;
-          }
-        }
-        return true;
+      const FnPtrSig* sig = lookup_fnptr_sig(&ctx, expr->args[0].get());
+      FnPtrSig inferred;
+      if (!sig) {
+        /* First arg is Ptr but target unknown (e.g. load_field): infer signature from call site. */
+        for (size_t k = 1; k < expr->args.size(); ++k) {
+          if (!check_expr(expr->args[k].get(), ctx)) return false;
+        }
+        for (size_t k = 1; k < expr->args.size(); ++k)
+          inferred.params.push_back(expr_type(expr->args[k].get(), &ctx));
+        inferred.result = ctx.has_expected_return_type ? ctx.expected_return_type : FfiType::Void;
+        expr->inferred_call_param_types = inferred.params;
+        expr->inferred_call_result_type = inferred.result;
+        sig = &inferred;
+      }
+      if (expr->args.size() - 1 != sig->params.size()) {
+        set_error(ctx, "call: wrong number of arguments for function pointer");
+        return false;
       }
-      if (expr->callee == "read_line") {
-        if (expr->args.size() != 0) {
-          ctx.err->message = "read_line expects no arguments";
+      for (size_t j = 0; j < sig->params.size(); ++j) {
+        CheckedType ct = check_and_type(expr->args[j + 1].get(), ctx);
+        if (!ct.ok) return false;
+        FfiType arg_ty = ct.ty;
+        if (arg_ty == FfiType::Ptr && is_stack_ptr(expr_flavor(expr->args[j + 1].get(), &ctx))) {
+          set_error(ctx, "cannot pass stack pointer to indirect call (unknown callee)");
           return false;
         }
-        expr->inferred_ptr_element = "char";
-        return true;
-      }
-      if (expr->callee == "read_key") {
-        if (expr->args.size() != 0) {
-          ctx.err->message = "read_key expects no arguments";
+        FfiType want = sig->params[j];
+        if (!compat_ok(kIndirectArgCompat, want, arg_ty)) {
+          set_error(ctx, "call: argument type mismatch for function pointer");
           return false;
         }
-        return true;
       }
-      if (expr->callee == "terminal_height") {
-        if (expr->args.size() != 0) {
-          ctx.err->message = "terminal_height expects no arguments";
-          return false;
-        }
-        return true;
+      return true;
+    }
+    case Builtin::Print:
+    case Builtin::Println: {
+      if (expr->args.size() != 1 && expr->args.size() != 2) {
+        set_error(ctx, expr->callee, " expects 1 or 2 arguments");
+        return false;
       }
-      if (expr->callee == "terminal_width") {
-        if (expr->args.size() != 0) {
-          ctx.err->message = "terminal_width expects no arguments";
-          return false;
-        }
-        return true;
+      CheckedType ct = check_and_type(expr->args[0].get(), ctx);
+      if (!ct.ok) return false;
+      FfiType arg_ty = ct.ty;
+      if (((kPrintableMask >> (int)arg_ty) & 1u) == 0) {
+        set_error(ctx, expr->callee, " expects i64, f64, or pointer argument");
+        return false;
       }
-      if (expr->callee == "flush") {
-        if (expr->args.size() != 1) {
-          ctx.err->message = "flush expects one argument (stream: 0 or 1)";
+      if (expr->args.size() == 2) {
+        CheckedType ct = check_and_type(expr->args[1].get(), ctx);
+        if (!ct.ok) return false;
+        if (ct.ty != FfiType::I64) {
+          set_error(ctx, expr->callee, " stream argument must be i64");
           return false;
         }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        return true;
       }
-      if (expr->callee == "sleep") {
-        if (expr->args.size() != 1) {
-          ctx.err->message = "sleep expects exactly one argument (milliseconds: i64)";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        return true;
+      return true;
+    }
+    case Builtin::ReadLine: {
+      if (expr->args.size() != 0) {
+        set_error(ctx, "read_line expects no arguments");
+        return false;
       }
-      if (expr->callee == "chr") {
-        if (expr->args.size() != 1) {
-          ctx.err->message = "chr expects exactly one argument";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        expr->inferred_ptr_element = "char";
-        return true;
+      expr->inferred_ptr_element = "char";
+      return true;
+    }
+    case Builtin::ReadKey: {
+      if (expr->args.size() != 0) {
+        set_error(ctx, "read_key expects no arguments");
+        return false;
       }
-      if (expr->callee == "to_str") {
-        if (expr->args.size() != 1) {
-          ctx.err->message = "to_str expects exactly one argument";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        FfiType t = expr_type(expr->args[0].get(), &ctx);
-        if (t != FfiType::I64 && t != FfiType::F64) {
-          ctx.err->message = "to_str expects i64 or f64 argument";
-          return false;
-        }
-        expr->inferred_ptr_element = "char";
-        return true;
+      return true;
+    }
+    case Builtin::TerminalHeight: {
+      if (expr->args.size() != 0) {
+        set_error(ctx, "terminal_height expects no arguments");
+        return false;
       }
-      if (expr->callee == "from_str") {
-        if (expr->args.size() != 1) {
-          ctx.err->message = "from_str expects one argument (string)";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx)) return false;
-        if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = "from_str expects pointer (string) argument";
-          return false;
-        }
-        if (expr->call_type_arg != "i64" && expr->call_type_arg != "f64") {
-          ctx.err->message = "from_str requires type argument: use from_str(s, i64) or from_str(s, f64)";
-          return false;
-        }
-        return true;
+      return true;
+    }
+    case Builtin::TerminalWidth: {
+      if (expr->args.size() != 0) {
+        set_error(ctx, "terminal_width expects no arguments");
+        return false;
       }
-      if (expr->callee == "open") {
-        if (expr->args.size() != 2) {
-          ctx.err->message = "open expects (path, mode)";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx)) return false;
-        if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr || expr_type(expr->args[1].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = "open expects two pointer (string) arguments";
-          return false;
-        }
-        return true;
+      return true;
+    }
+    case Builtin::Flush: {
+      if (expr->args.size() != 1) {
+        set_error(ctx, "flush expects one argument (stream: 0 or 1)");
+        return false;
       }
-      if (expr->callee == "close")
-        return check_one_ptr_arg(expr, "close", "file handle", ctx);
-      if (expr->callee == "read_line_file") {
-        if (!check_one_ptr_arg(expr, "read_line_file", "file handle", ctx)) return false;
-        expr->inferred_ptr_element = "char";
-        return true;
+      if (!check_expr(expr->args[0].get(), ctx)) return false;
+      return true;
+    }
+    case Builtin::Sleep: {
+      if (expr->args.size() != 1) {
+        set_error(ctx, "sleep expects exactly one argument (milliseconds: i64)");
+        return false;
       }
-      if (expr->callee == "str_dup") {
-        if (!check_one_ptr_arg(expr, "str_dup", "string", ctx)) return false;
-        expr->inferred_ptr_element = "char";
-        return true;
+      if (!check_expr(expr->args[0].get(), ctx)) return false;
+      return true;
+    }
+    case Builtin::Chr: {
+      if (expr->args.size() != 1) {
+        set_error(ctx, "chr expects exactly one argument");
+        return false;
       }
-      if (expr->callee == "str_upper" || expr->callee == "str_lower" || expr->callee == "str_strip") {
-        if (!check_one_ptr_arg(expr, expr->callee.c_str(), "string", ctx)) return false;
-        expr->inferred_ptr_element = "char";
-        return true;
+      if (!check_expr(expr->args[0].get(), ctx)) return false;
+      expr->inferred_ptr_element = "char";
+      return true;
+    }
+    case Builtin::ToStr: {
+      if (expr->args.size() != 1) {
+        set_error(ctx, "to_str expects exactly one argument");
+        return false;
       }
-      if (expr->callee == "str_contains" || expr->callee == "str_find") {
-        if (expr->args.size() != 2) {
-          ctx.err->message = expr->callee + " expects (haystack, needle)";
-          return false;
-        }
-        for (auto& a : expr->args)
-          if (!check_expr(a.get(), ctx)) return false;
-        return true;
-      }
-      if (expr->callee == "str_split") {
-        if (expr->args.size() != 2) {
-          ctx.err->message = "str_split expects (string, delimiter)";
-          return false;
-        }
-        for (auto& a : expr->args)
-          if (!check_expr(a.get(), ctx)) return false;
-        return true;
-      }
-      if (expr->callee == "http_request") {
-        if (expr->args.size() != 3) {
-          ctx.err->message = "http_request expects (method, url, body)";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx) || !check_expr(expr->args[2].get(), ctx)) return false;
-        if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr || expr_type(expr->args[1].get(), &ctx) != FfiType::Ptr || expr_type(expr->args[2].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = "http_request expects three pointer (string) arguments; use \"\" for body when no body";
-          return false;
-        }
-        expr->inferred_ptr_element = "char";
-        return true;
-      }
-      if (expr->callee == "http_status") {
-        if (expr->args.size() != 0) {
-          ctx.err->message = "http_status expects no arguments";
-          return false;
-        }
-        return true;
-      }
-      if (expr->callee == "write_file") {
-        if (expr->args.size() != 2) {
-          ctx.err->message = "write_file expects (handle, value)";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx)) return false;
-        if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = "write_file first argument must be pointer (file handle)";
-          return false;
-        }
-        FfiType val_ty = expr_type(expr->args[1].get(), &ctx);
-        if (val_ty != FfiType::I64 && val_ty != FfiType::F64 && val_ty != FfiType::Ptr) {
-          ctx.err->message = "write_file second argument must be i64, f64, or ptr";
-          return false;
-        }
-        return true;
-      }
-      if (expr->callee == "write_bytes" || expr->callee == "read_bytes") {
-        if (expr->args.size() != 3) {
-          ctx.err->message = expr->callee + " expects (handle, buffer, count)";
-          return false;
-        }
-        if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx) || !check_expr(expr->args[2].get(), ctx)) return false;
-        if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = std::string(expr->callee) + " first argument must be pointer (file handle)";
-          return false;
-        }
-        if (expr_type(expr->args[1].get(), &ctx) != FfiType::Ptr) {
-          ctx.err->message = std::string(expr->callee) + " second argument must be pointer (buffer)";
-          return false;
-        }
-        if (expr_type(expr->args[2].get(), &ctx) != FfiType::I64) {
-          ctx.err->message = std::string(expr->callee) + " third argument must be i64 (byte count)";
-          return false;
-        }
-        return true;
-      }
-      if (expr->callee == "eof_file")
-        return check_one_ptr_arg(expr, "eof_file", "file handle", ctx);
-      if (expr->callee == "line_count_file")
-        return check_one_ptr_arg(expr, "line_count_file", "file handle", ctx);
-      if (expr->callee == "len")
-        return check_one_ptr_arg(expr, "len", "array", ctx);
-      auto ext_it = ctx.extern_fn_by_name.find(expr->callee);
-      if (ext_it != ctx.extern_fn_by_name.end()) {
-        const ExternFn& ext = ext_it->second;
-        if (expr->args.size() != ext.params.size()) {
-          ctx.err->message = "call to '" + expr->callee + "' has wrong number of arguments";
-          return false;
-        }
-        for (size_t j = 0; j < expr->args.size(); ++j) {
-          if (!check_expr(expr->args[j].get(), ctx)) return false;
-          FfiType arg_ty = expr_type(expr->args[j].get(), &ctx);
-          if (arg_ty != ext.params[j].second) {
-            ctx.err->message = "argument type mismatch in call to '" + expr->callee + "'";
-            return false;
-          }
-          if (arg_ty == FfiType::Ptr && is_stack_ptr(expr_flavor(expr->args[j].get(), &ctx))) {
-            ctx.err->message = "cannot pass stack pointer to extern function '" + expr->callee + "'";
-            return false;
-          }
-        }
-        if (ext.return_type == FfiType::Ptr && !ext.return_type_name.empty())
-          expr->inferred_ptr_element = ext.return_type_name;
-        return true;
-      }
-      auto user_it = ctx.user_fn_by_name.find(expr->callee);
-      if (user_it != ctx.user_fn_by_name.end()) {
-        const FnDef& def = *user_it->second;
-        if (expr->args.size() != def.params.size()) {
-          ctx.err->message = "call to '" + expr->callee + "' has wrong number of arguments";
-          return false;
-        }
-        for (size_t j = 0; j < expr->args.size(); ++j) {
-          if (!check_expr(expr->args[j].get(), ctx)) return false;
-          FfiType arg_ty = expr_type(expr->args[j].get(), &ctx);
-          if (arg_ty != def.params[j].second) {
-            ctx.err->message = "argument type mismatch in call to '" + expr->callee + "'";
-            return false;
-          }
-          bool noescape = (j < def.param_noescape.size() && def.param_noescape[j]);
-          if (arg_ty == FfiType::Ptr && is_stack_ptr(expr_flavor(expr->args[j].get(), &ctx)) && !noescape) {
-            ctx.err->message = "cannot pass stack pointer to '" + expr->callee + "' (param not noescape)";
-            return false;
-          }
-        }
-        if (def.return_type == FfiType::Ptr && !def.return_type_name.empty())
-          expr->inferred_ptr_element = def.return_type_name;
-        return true;
-      }
-      ctx.err->message = "unknown function '" + expr->callee + "'";
-      return false;
-    }
-    case Expr::Kind::VarRef: {
-      FfiType ty;
-      if (!var_type_lookup(&ctx, expr->var_name, &ty)) {
-        ctx.err->message = "undefined variable '" + expr->var_name + "'";
+      CheckedType ct = check_and_type(expr->args[0].get(), ctx);
+      if (!ct.ok) return false;
+      FfiType t = ct.ty;
+      if (t != FfiType::I64 && t != FfiType::F64) {
+        set_error(ctx, "to_str expects i64 or f64 argument");
         return false;
       }
-      if (ty == FfiType::Ptr) {
-        std::string pe = var_ptr_element_lookup(&ctx, expr->var_name);
-        if (!pe.empty()) expr->inferred_ptr_element = pe;
-      }
+      expr->inferred_ptr_element = "char";
       return true;
     }
-    case Expr::Kind::StackAlloc:
-    case Expr::Kind::HeapAlloc:
-      if (!is_alloc_type(expr->var_name, ctx.program)) {
-        ctx.err->message = "stack/heap: unknown type '" + expr->var_name + "'";
+    case Builtin::FromStr: {
+      if (expr->args.size() != 1) {
+        set_error(ctx, "from_str expects one argument (string)");
         return false;
       }
-      return true;
-    case Expr::Kind::StackArray:
-    case Expr::Kind::HeapArray:
-      if (!expr->left) return false;
-      if (!is_alloc_type(expr->var_name, ctx.program)) {
-        ctx.err->message = "stack_array/heap_array: unknown element type '" + expr->var_name + "'";
+      CheckedType ct = check_and_type(expr->args[0].get(), ctx);
+      if (!ct.ok) return false;
+      if (ct.ty != FfiType::Ptr) {
+        set_error(ctx, "from_str expects pointer (string) argument");
         return false;
       }
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::I64) {
-        ctx.err->message = "stack_array/heap_array: count must be i64";
+      if (expr->call_type_arg != "i64" && expr->call_type_arg != "f64") {
+        set_error(ctx, "from_str requires type argument: use from_str(s, i64) or from_str(s, f64)");
         return false;
       }
       return true;
-    case Expr::Kind::Index:
-      if (!expr->left || !expr->right) return false;
-      if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "index: base must be a pointer (array)";
+    }
+    case Builtin::Open: {
+      if (expr->args.size() != 2) {
+        set_error(ctx, "open expects (path, mode)");
         return false;
       }
-      if (expr_type(expr->right.get(), &ctx) != FfiType::I64) {
-        ctx.err->message = "index: index must be i64";
+      if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx)) return false;
+      if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr || expr_type(expr->args[1].get(), &ctx) != FfiType::Ptr) {
+        set_error(ctx, "open expects two pointer (string) arguments");
         return false;
       }
       return true;
-    case Expr::Kind::Free: {
-      if (!expr->left) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "free: argument must be a pointer";
-        return false;
-      }
-      AllocFlavor f = expr_flavor(expr->left.get(), &ctx);
-      if (f == AllocFlavor::HeapSingle) return true;
-      if (f == AllocFlavor::StackSingle || f == AllocFlavor::StackArrayElementsPtr ||
-          f == AllocFlavor::HeapArrayElementsPtr) {
-        ctx.err->message = "free: use free_array for array allocations; cannot free stack allocation";
-        return false;
-      }
-      ctx.err->message = "free: unknown pointer origin; use as_heap(ptr) to assert heap allocation";
-      return false;
     }
-    case Expr::Kind::FreeArray: {
-      if (!expr->left) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "free_array: argument must be a pointer";
-        return false;
-      }
-      AllocFlavor fa = expr_flavor(expr->left.get(), &ctx);
-      if (fa == AllocFlavor::HeapArrayElementsPtr) return true;
-      if (fa == AllocFlavor::HeapSingle || fa == AllocFlavor::StackSingle ||
-          fa == AllocFlavor::StackArrayElementsPtr) {
-        ctx.err->message = "free_array: use free for single allocations; cannot free stack allocation";
-        return false;
-      }
-      ctx.err->message = "free_array: unknown pointer origin; use as_array(ptr, T) to assert array allocation";
-      return false;
+    case Builtin::Close:
+      return check_one_ptr_arg(expr, "close", "file handle", ctx);
+    case Builtin::ReadLineFile: {
+      if (!check_one_ptr_arg(expr, "read_line_file", "file handle", ctx)) return false;
+      expr->inferred_ptr_element = "char";
+      return true;
     }
-    case Expr::Kind::AsHeap:
-    case Expr::Kind::AsArray:
-      if (!expr->left) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "as_heap/as_array: argument must be a pointer";
-        ctx.err->line = expr->left->line != 0 ? expr->left->line : expr->line;
-        ctx.err->column = expr->left->column != 0 ? expr->left->column : expr->column;
+    case Builtin::StrDup: {
+      if (!check_one_ptr_arg(expr, "str_dup", "string", ctx)) return false;
+      expr->inferred_ptr_element = "char";
+      return true;
+    }
+    case Builtin::StrUpper:
+    case Builtin::StrLower:
+    case Builtin::StrStrip: {
+      if (!check_one_ptr_arg(expr, expr->callee.c_str(), "string", ctx)) return false;
+      expr->inferred_ptr_element = "char";
+      return true;
+    }
+    case Builtin::StrContains:
+    case Builtin::StrFind: {
+      if (expr->args.size() != 2) {
+        set_error(ctx, expr->callee, " expects (haystack, needle)");
         return false;
       }
-      if (expr->kind == Expr::Kind::AsArray && !is_alloc_type(expr->var_name, ctx.program)) {
-        ctx.err->message = "as_array: unknown element type '" + expr->var_name + "'";
+      for (auto& a : expr->args)
+        if (!check_expr(a.get(), ctx)) return false;
+      return true;
+    }
+    case Builtin::StrSplit: {
+      if (expr->args.size() != 2) {
+        set_error(ctx, "str_split expects (string, delimiter)");
         return false;
       }
+      for (auto& a : expr->args)
+        if (!check_expr(a.get(), ctx)) return false;
       return true;
-    case Expr::Kind::AddrOf:
-      if (!expr->left || expr->left->kind != Expr::Kind::VarRef) {
-        ctx.err->message = "addr_of: argument must be a variable";
+    }
+    case Builtin::HttpRequest: {
+      if (expr->args.size() != 3) {
+        set_error(ctx, "http_request expects (method, url, body)");
         return false;
       }
-      return check_expr(expr->left.get(), ctx);
-    case Expr::Kind::Load:
-    case Expr::Kind::LoadF64:
-    case Expr::Kind::LoadI32:
-    case Expr::Kind::LoadPtr:
-      if (!expr->left) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "load/load_f64/load_ptr: argument must be a pointer";
+      if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx) || !check_expr(expr->args[2].get(), ctx)) return false;
+      if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr || expr_type(expr->args[1].get(), &ctx) != FfiType::Ptr || expr_type(expr->args[2].get(), &ctx) != FfiType::Ptr) {
+        set_error(ctx, "http_request expects three pointer (string) arguments; use \"\" for body when no body");
         return false;
       }
+      expr->inferred_ptr_element = "char";
       return true;
-    case Expr::Kind::Store:
-      if (!expr->left || !expr->right) return false;
-      if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "store: first argument must be a pointer";
-        return false;
-      }
-      if (expr_type(expr->right.get(), &ctx) == FfiType::Ptr &&
-          is_stack_ptr(expr_flavor(expr->right.get(), &ctx)) &&
-          may_outlive_function(expr_base(expr->left.get(), &ctx))) {
-        ctx.err->message = "store: cannot store stack pointer into memory that may outlive function";
+    }
+    case Builtin::HttpStatus: {
+      if (expr->args.size() != 0) {
+        set_error(ctx, "http_status expects no arguments");
         return false;
       }
       return true;
-    case Expr::Kind::LoadField: {
-      if (!expr->left) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "load_field: first argument must be a pointer";
+    }
+    case Builtin::WriteFile: {
+      if (expr->args.size() != 2) {
+        set_error(ctx, "write_file expects (handle, value)");
         return false;
       }
-      if (!ctx.layout_map) return false;
-      auto it = ctx.layout_map->find(expr->load_field_struct);
-      if (it == ctx.layout_map->end()) {
-        ctx.err->message = "load_field: unknown struct '" + expr->load_field_struct + "'";
+      if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx)) return false;
+      if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
+        set_error(ctx, "write_file first argument must be pointer (file handle)");
         return false;
       }
-      for (const auto& f : it->second.fields)
-        if (f.first == expr->load_field_field) return true;
-      ctx.err->message = "load_field: unknown field '" + expr->load_field_field + "' in struct '" + expr->load_field_struct + "'";
-      return false;
-    }
-    case Expr::Kind::StoreField: {
-      if (!expr->left || !expr->right) return false;
-      if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "store_field: first argument must be a pointer";
+      FfiType val_ty = expr_type(expr->args[1].get(), &ctx);
+      if (((kPrintableMask >> (int)val_ty) & 1u) == 0) {
+        set_error(ctx, "write_file second argument must be i64, f64, or ptr");
         return false;
       }
-      if (!ctx.layout_map) return false;
-      auto it = ctx.layout_map->find(expr->load_field_struct);
-      if (it == ctx.layout_map->end()) {
-        ctx.err->message = "store_field: unknown struct '" + expr->load_field_struct + "'";
+      return true;
+    }
+    case Builtin::WriteBytes:
+    case Builtin::ReadBytes: {
+      if (expr->args.size() != 3) {
+        set_error(ctx, expr->callee, " expects (handle, buffer, count)");
         return false;
       }
-      FfiType field_ty = FfiType::Void;
-      for (const auto& f : it->second.fields)
-        if (f.first == expr->load_field_field) { field_ty = f.second.type; break; }
-      if (field_ty == FfiType::Void) {
-        ctx.err->message = "store_field: unknown field '" + expr->load_field_field + "' in struct '" + expr->load_field_struct + "'";
+      if (!check_expr(expr->args[0].get(), ctx) || !check_expr(expr->args[1].get(), ctx) || !check_expr(expr->args[2].get(), ctx)) return false;
+      if (expr_type(expr->args[0].get(), &ctx) != FfiType::Ptr) {
+        set_error(ctx, expr->callee, " first argument must be pointer (file handle)");
         return false;
       }
-      FfiType val_ty = expr_type(expr->right.get(), &ctx);
-      bool compat = (val_ty == field_ty) ||
-        (val_ty == FfiType::Ptr && field_ty == FfiType::I64) ||
-        (val_ty == FfiType::I64 && field_ty == FfiType::Ptr);
-      if (!compat) {
-        ctx.err->message = "store_field: value type does not match field type";
+      if (expr_type(expr->args[1].get(), &ctx) != FfiType::Ptr) {
+        set_error(ctx, expr->callee, " second argument must be pointer (buffer)");
         return false;
       }
-      if (field_ty == FfiType::Ptr &&
-          is_stack_ptr(expr_flavor(expr->right.get(), &ctx)) &&
-          may_outlive_function(expr_base(expr->left.get(), &ctx))) {
-        ctx.err->message = "store_field: cannot store stack pointer into memory that may outlive function";
+      if (expr_type(expr->args[2].get(), &ctx) != FfiType::I64) {
+        set_error(ctx, expr->callee, " third argument must be i64 (byte count)");
         return false;
       }
       return true;
     }
-    case Expr::Kind::FieldAccess: {
-      if (!expr->left || expr->field_chain.empty()) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
-        ctx.err->message = "field access: base must be a pointer";
-        return false;
-      }
-      if (!ctx.layout_map) return false;
-      std::string struct_name = expr_struct_name(expr->left.get(), &ctx);
-      if (struct_name.empty() && expr->left->kind == Expr::Kind::VarRef) {
-        std::string pe = var_ptr_element_lookup(&ctx, expr->left->var_name);
-        if (!pe.empty() && ctx.program && is_named_type_known(pe, ctx.program))
-          struct_name = pe;
-      }
-      if (struct_name.empty()) {
-        ctx.err->message = "field access: cannot determine struct type of base expression";
+    case Builtin::EofFile:
+      return check_one_ptr_arg(expr, "eof_file", "file handle", ctx);
+    case Builtin::LineCountFile:
+      return check_one_ptr_arg(expr, "line_count_file", "file handle", ctx);
+    case Builtin::Len:
+      return check_one_ptr_arg(expr, "len", "array", ctx);
+    case Builtin::None:
+      break;
+  }
+
+  const CalleeInfo* info = callee_info(expr, expr->callee, &ctx);
+  if (FUSION_LIKELY(info && (info->ext || info->user))) {
+    /* Extern and user calls validate identically against the flattened
+     * param_types; the only behavioral splits are the noescape escape hatch
+     * (user fns only) and which declaration supplies the return element
+     * type, so one loop serves both. */
+    const std::vector<bool>* noescape = info->user ? &info->user->param_noescape : nullptr;
+    if (expr->args.size() != info->sig.params.size()) {
+      set_error(ctx, "call to '", expr->callee, "' has wrong number of arguments");
+      return false;
+    }
+    for (size_t j = 0; j < expr->args.size(); ++j) {
+      if (j + 1 < expr->args.size())
+        __builtin_prefetch(expr->args[j + 1].get(), 0, 0);
+      CheckedType ct = check_and_type(expr->args[j].get(), ctx);
+      if (!ct.ok) return false;
+      FfiType arg_ty = ct.ty;
+      if (arg_ty != info->sig.params[j]) {
+        set_error(ctx, "argument type mismatch in call to '", expr->callee, "'");
         return false;
       }
-      // Annotate for codegen
-      expr->load_field_struct = struct_name;
-      std::string cur = struct_name;
-      for (size_t fi = 0; fi < expr->field_chain.size(); ++fi) {
-        auto it = ctx.layout_map->find(cur);
-        if (it == ctx.layout_map->end()) {
-          ctx.err->message = "field access: unknown struct '" + cur + "'";
+      if (arg_ty == FfiType::Ptr && is_stack_ptr(expr_flavor(expr->args[j].get(), &ctx))) {
+        if (!noescape) {
+          set_error(ctx, "cannot pass stack pointer to extern function '", expr->callee, "'");
           return false;
         }
-        const std::string& field = expr->field_chain[fi];
-        bool found = false;
-        for (const auto& f : it->second.fields) {
-          if (f.first == field) {
-            if (fi + 1 < expr->field_chain.size()) {
-              if (f.second.struct_name.empty()) {
-                ctx.err->message = "field access: intermediate field '" + field +
-                    "' is not an embedded struct in '" + cur + "'";
-                return false;
-              }
-              cur = f.second.struct_name;
-            }
-            found = true;
-            break;
-          }
-        }
-        if (!found) {
-          ctx.err->message = "field access: unknown field '" + field + "' in struct '" + cur + "'";
+        if (!(j < noescape->size() && (*noescape)[j])) {
+          set_error(ctx, "cannot pass stack pointer to '", expr->callee, "' (param not noescape)");
           return false;
         }
       }
-      return true;
     }
-    case Expr::Kind::Cast: {
-      if (!expr->left || expr->var_name.empty()) return false;
-      if (!check_expr(expr->left.get(), ctx)) return false;
-      FfiType from = expr_type(expr->left.get(), &ctx);
-      if (expr->var_name == "ptr" || expr->var_name == "char") {
-        if (from != FfiType::Ptr) {
-          ctx.err->message = "cast to ptr: operand must be a pointer";
-          return false;
-        }
-        if (expr->var_name == "char") expr->inferred_ptr_element = "char";
-        return true;
-      }
-      if (expr->var_name == "i64" || expr->var_name == "i32" || expr->var_name == "f64" || expr->var_name == "f32") {
-        bool from_numeric = (from == FfiType::I64 || from == FfiType::I32 || from == FfiType::I8 || from == FfiType::F64 || from == FfiType::F32);
-        if (!from_numeric) {
-          ctx.err->message = "cast to numeric type: operand must be i64, i32, f64, or f32";
+    const std::string& ret_name =
+        info->user ? info->user->return_type_name : info->ext->return_type_name;
+    if (info->sig.result == FfiType::Ptr && !ret_name.empty())
+      expr->inferred_ptr_element = ret_name;
+    return true;
+  }
+  set_error(ctx, "unknown function '", expr->callee, "'");
+  return false;
+}
+
+static bool check_var_ref(Expr* expr, SemaContext& ctx) {
+  FfiType ty;
+  if (!var_type_lookup(&ctx, expr->var_name, &ty)) {
+    set_error(ctx, "undefined variable '", expr->var_name, "'");
+    return false;
+  }
+  if (ty == FfiType::Ptr) {
+    std::string pe = var_ptr_element_lookup(&ctx, expr->var_name);
+    if (!pe.empty()) expr->inferred_ptr_element = pe;
+  }
+  return true;
+}
+
+static bool check_alloc(Expr* expr, SemaContext& ctx) {
+  if (!is_alloc_type(expr->var_name, &ctx)) {
+    set_error(ctx, "stack/heap: unknown type '", expr->var_name, "'");
+    return false;
+  }
+  return true;
+}
+
+static bool check_array_alloc(Expr* expr, SemaContext& ctx) {
+  if (!expr->left) return false;
+  if (!is_alloc_type(expr->var_name, &ctx)) {
+    set_error(ctx, "stack_array/heap_array: unknown element type '", expr->var_name, "'");
+    return false;
+  }
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::I64) {
+    set_error(ctx, "stack_array/heap_array: count must be i64");
+    return false;
+  }
+  return true;
+}
+
+static bool check_index(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || !expr->right) return false;
+  if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
+  if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
+    set_error(ctx, "index: base must be a pointer (array)");
+    return false;
+  }
+  if (expr_type(expr->right.get(), &ctx) != FfiType::I64) {
+    set_error(ctx, "index: index must be i64");
+    return false;
+  }
+  return true;
+}
+
+static bool check_free(Expr* expr, SemaContext& ctx) {
+  if (!expr->left) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::Ptr) {
+    set_error(ctx, "free: argument must be a pointer");
+    return false;
+  }
+  AllocFlavor f = expr_flavor(expr->left.get(), &ctx);
+  if (f == AllocFlavor::HeapSingle) return true;
+  if (f == AllocFlavor::StackSingle || f == AllocFlavor::StackArrayElementsPtr ||
+      f == AllocFlavor::HeapArrayElementsPtr) {
+    set_error(ctx, "free: use free_array for array allocations; cannot free stack allocation");
+    return false;
+  }
+  set_error(ctx, "free: unknown pointer origin; use as_heap(ptr) to assert heap allocation");
+  return false;
+}
+
+static bool check_free_array(Expr* expr, SemaContext& ctx) {
+  if (!expr->left) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::Ptr) {
+    set_error(ctx, "free_array: argument must be a pointer");
+    return false;
+  }
+  AllocFlavor fa = expr_flavor(expr->left.get(), &ctx);
+  if (fa == AllocFlavor::HeapArrayElementsPtr) return true;
+  if (fa == AllocFlavor::HeapSingle || fa == AllocFlavor::StackSingle ||
+      fa == AllocFlavor::StackArrayElementsPtr) {
+    set_error(ctx, "free_array: use free for single allocations; cannot free stack allocation");
+    return false;
+  }
+  set_error(ctx, "free_array: unknown pointer origin; use as_array(ptr, T) to assert array allocation");
+  return false;
+}
+
+static bool check_as_cast(Expr* expr, SemaContext& ctx) {
+  if (!expr->left) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::Ptr) {
+    set_error(ctx, "as_heap/as_array: argument must be a pointer");
+    ctx.err->line = expr->left->line != 0 ? expr->left->line : expr->line;
+    ctx.err->column = expr->left->column != 0 ? expr->left->column : expr->column;
+    return false;
+  }
+  if (expr->kind == Expr::Kind::AsArray && !is_alloc_type(expr->var_name, &ctx)) {
+    set_error(ctx, "as_array: unknown element type '", expr->var_name, "'");
+    return false;
+  }
+  return true;
+}
+
+static bool check_addr_of(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || expr->left->kind != Expr::Kind::VarRef) {
+    set_error(ctx, "addr_of: argument must be a variable");
+    return false;
+  }
+  return check_expr(expr->left.get(), ctx);
+}
+
+static bool check_load(Expr* expr, SemaContext& ctx) {
+  if (!expr->left) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::Ptr) {
+    set_error(ctx, "load/load_f64/load_ptr: argument must be a pointer");
+    return false;
+  }
+  return true;
+}
+
+static bool check_store(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || !expr->right) return false;
+  if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
+  if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
+    set_error(ctx, "store: first argument must be a pointer");
+    return false;
+  }
+  if (expr_type(expr->right.get(), &ctx) == FfiType::Ptr &&
+      is_stack_ptr(expr_flavor(expr->right.get(), &ctx)) &&
+      may_outlive_function(expr_base(expr->left.get(), &ctx))) {
+    set_error(ctx, "store: cannot store stack pointer into memory that may outlive function");
+    return false;
+  }
+  return true;
+}
+
+/* Resolve struct-name + field-name to the field layout, or nullptr if either
+ * is unknown. One definition for the LoadField/StoreField check and type
+ * paths. With expression types memoized this runs once per node. */
+static const FieldLayout* lookup_field(const std::string& struct_name,
+                                       const std::string& field_name,
+                                       const SemaContext* ctx) {
+  if (!ctx || !ctx->layout_map) return nullptr;
+  auto it = ctx->layout_map->find(struct_name);
+  if (it == ctx->layout_map->end()) return nullptr;
+  return it->second.find_field(field_name);
+}
+
+static bool check_load_field(Expr* expr, SemaContext& ctx) {
+  if (!expr->left) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::Ptr) {
+    set_error(ctx, "load_field: first argument must be a pointer");
+    return false;
+  }
+  if (!ctx.layout_map) return false;
+  auto it = ctx.layout_map->find(expr->load_field_struct);
+  if (it == ctx.layout_map->end()) {
+    set_error(ctx, "load_field: unknown struct '", expr->load_field_struct, "'");
+    return false;
+  }
+  if (it->second.find_field(expr->load_field_field)) return true;
+  set_error(ctx, "load_field: unknown field '", expr->load_field_field, "' in struct '", expr->load_field_struct, "'");
+  return false;
+}
+
+static bool check_store_field(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || !expr->right) return false;
+  if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
+  if (expr_type(expr->left.get(), &ctx) != FfiType::Ptr) {
+    set_error(ctx, "store_field: first argument must be a pointer");
+    return false;
+  }
+  if (!ctx.layout_map) return false;
+  auto it = ctx.layout_map->find(expr->load_field_struct);
+  if (it == ctx.layout_map->end()) {
+    set_error(ctx, "store_field: unknown struct '", expr->load_field_struct, "'");
+    return false;
+  }
+  FfiType field_ty = FfiType::Void;
+  if (const FieldLayout* f = it->second.find_field(expr->load_field_field))
+    field_ty = f->type;
+  if (field_ty == FfiType::Void) {
+    set_error(ctx, "store_field: unknown field '", expr->load_field_field, "' in struct '", expr->load_field_struct, "'");
+    return false;
+  }
+  FfiType val_ty = expr_type(expr->right.get(), &ctx);
+  if (!compat_ok(kAssignCompat, field_ty, val_ty)) {
+    set_error(ctx, "store_field: value type does not match field type");
+    return false;
+  }
+  if (field_ty == FfiType::Ptr &&
+      is_stack_ptr(expr_flavor(expr->right.get(), &ctx)) &&
+      may_outlive_function(expr_base(expr->left.get(), &ctx))) {
+    set_error(ctx, "store_field: cannot store stack pointer into memory that may outlive function");
+    return false;
+  }
+  return true;
+}
+
+static bool check_field_access(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || expr->field_chain.empty()) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  if (ct.ty != FfiType::Ptr) {
+    set_error(ctx, "field access: base must be a pointer");
+    return false;
+  }
+  if (!ctx.layout_map) return false;
+  std::string struct_name = expr_struct_name(expr->left.get(), &ctx);
+  if (struct_name.empty() && expr->left->kind == Expr::Kind::VarRef) {
+    std::string pe = var_ptr_element_lookup(&ctx, expr->left->var_name);
+    if (!pe.empty() && ctx.program && is_named_type_known(pe, &ctx))
+      struct_name = pe;
+  }
+  if (struct_name.empty()) {
+    set_error(ctx, "field access: cannot determine struct type of base expression");
+    return false;
+  }
+  // Annotate for codegen
+  expr->load_field_struct = struct_name;
+  std::string cur = struct_name;
+  for (size_t fi = 0; fi < expr->field_chain.size(); ++fi) {
+    auto it = ctx.layout_map->find(cur);
+    if (it == ctx.layout_map->end()) {
+      set_error(ctx, "field access: unknown struct '", cur, "'");
+      return false;
+    }
+    const std::string& field = expr->field_chain[fi];
+    bool found = false;
+    if (const FieldLayout* f = it->second.find_field(field)) {
+      if (fi + 1 < expr->field_chain.size()) {
+        if (f->struct_name.empty()) {
+          set_error(ctx, "field access: intermediate field '", field, "' is not an embedded struct in '", cur, "'");
           return false;
         }
-        return true;
-      }
-      /* Cast to struct: ptr -> struct* (reinterpret) */
-      if (ctx.program) {
-        for (const auto& s : ctx.program->struct_defs) {
-          if (s.name == expr->var_name) {
-            if (from != FfiType::Ptr) {
-              ctx.err->message = "cast to struct: operand must be a pointer";
-              return false;
-            }
-            return true;
-          }
-        }
+        cur = f->struct_name;
       }
-      ctx.err->message = "cast: target type must be ptr[void], ptr[char], i64, i32, f64, f32, or a struct name";
+      found = true;
+    }
+    if (!found) {
+      set_error(ctx, "field access: unknown field '", field, "' in struct '", cur, "'");
       return false;
     }
-    case Expr::Kind::Compare: {
-      if (!expr->left || !expr->right) return false;
-      if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
-      FfiType l = expr_type(expr->left.get(), &ctx);
-      FfiType r = expr_type(expr->right.get(), &ctx);
-      if (l == FfiType::Ptr && r == FfiType::Ptr) {
-        if (expr->compare_op != CompareOp::Eq && expr->compare_op != CompareOp::Ne) {
-          ctx.err->message = "pointer comparison only supports == and !=";
-          return false;
-        }
-        return true;
+  }
+  return true;
+}
+
+static bool check_cast(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || expr->var_name.empty()) return false;
+  CheckedType ct = check_and_type(expr->left.get(), ctx);
+  if (!ct.ok) return false;
+  FfiType from = ct.ty;
+  switch (pack_type_name(expr->var_name)) {
+    case pack_type_name("ptr", 3):
+    case pack_type_name("char", 4):
+      if (from != FfiType::Ptr) {
+        set_error(ctx, "cast to ptr: operand must be a pointer");
+        return false;
       }
-      bool numeric = (l == FfiType::I64 || l == FfiType::F64) && (r == FfiType::I64 || r == FfiType::F64);
-      if (!numeric) {
-        ctx.err->message = "comparison operands must be numeric (i64 or f64)";
+      if (expr->var_name == "char") expr->inferred_ptr_element = "char";
+      return true;
+    case pack_type_name("i64", 3):
+    case pack_type_name("i32", 3):
+    case pack_type_name("f64", 3):
+    case pack_type_name("f32", 3): {
+      bool from_numeric = ((kCastNumericMask >> (int)from) & 1u) != 0;
+      if (!from_numeric) {
+        set_error(ctx, "cast to numeric type: operand must be i64, i32, f64, or f32");
         return false;
       }
       return true;
     }
+    default:
+      break;
   }
+  /* Cast to struct: ptr -> struct* (reinterpret) */
+  if (ctx.struct_names && ctx.struct_names->contains(expr->var_name)) {
+    if (from != FfiType::Ptr) {
+      set_error(ctx, "cast to struct: operand must be a pointer");
+      return false;
+    }
+    return true;
+  }
+  set_error(ctx, "cast: target type must be ptr[void], ptr[char], i64, i32, f64, f32, or a struct name");
   return false;
 }
 
-static FfiType expr_type(Expr* expr, SemaContext* ctx) {
-  if (!expr) return FfiType::Void;
-  switch (expr->kind) {
-    case Expr::Kind::IntLiteral:
-      return FfiType::I64;
-    case Expr::Kind::FloatLiteral:
-      return FfiType::F64;
-    case Expr::Kind::StringLiteral:
-      return FfiType::Ptr;
-    case Expr::Kind::BinaryOp: {
-      FfiType l = expr_type(expr->left.get(), ctx);
-      FfiType r = expr_type(expr->right.get(), ctx);
-      if (l == FfiType::Ptr && r == FfiType::Ptr && expr->bin_op == BinOp::Add)
-        return FfiType::Ptr;
-      return (l == FfiType::F64 || r == FfiType::F64) ? FfiType::F64 : FfiType::I64;
-    }
-    case Expr::Kind::Call: {
-      if (auto bt = builtin_fixed_return_type(expr->callee)) return *bt;
-      if (expr->callee == "call") {
-        if (ctx) {
-          FnPtrSig sig;
-          if (expr->args.size() >= 1 && lookup_fnptr_sig(ctx, expr->args[0].get(), &sig))
-            return sig.result;
-          if (!expr->inferred_call_param_types.empty())
-            return expr->inferred_call_result_type;
-        }
-        return FfiType::Void;
-      }
-      if (expr->callee == "from_str") {
-        if (expr->call_type_arg == "i64") return FfiType::I64;
-        if (expr->call_type_arg == "f64") return FfiType::F64;
-        return FfiType::Void;
-      }
-      if (ctx) {
-        auto ext_it = ctx->extern_fn_by_name.find(expr->callee);
-        if (ext_it != ctx->extern_fn_by_name.end()) return ext_it->second.return_type;
-        auto user_it = ctx->user_fn_by_name.find(expr->callee);
-        if (user_it != ctx->user_fn_by_name.end()) return user_it->second->return_type;
-      }
-      return FfiType::Void;
-    }
-    case Expr::Kind::VarRef:
-      if (ctx) {
-        FfiType ty;
-        if (var_type_lookup(ctx, expr->var_name, &ty)) return ty;
-      }
-      return FfiType::Void;
-    case Expr::Kind::StackAlloc:
-    case Expr::Kind::HeapAlloc:
-    case Expr::Kind::StackArray:
-    case Expr::Kind::HeapArray:
-      return FfiType::Ptr;
-    case Expr::Kind::Free:
-    case Expr::Kind::FreeArray:
-      return FfiType::Void;
-    case Expr::Kind::AsHeap:
-    case Expr::Kind::AsArray:
-      return FfiType::Ptr;
-    case Expr::Kind::AddrOf:
-      return FfiType::Ptr;
-    case Expr::Kind::Load:
-    case Expr::Kind::LoadI32:
-      return FfiType::I64;
-    case Expr::Kind::LoadF64:
-      return FfiType::F64;
-    case Expr::Kind::LoadPtr:
-      return FfiType::Ptr;
-    case Expr::Kind::Store:
-    case Expr::Kind::StoreField:
-      return FfiType::Void;
-    case Expr::Kind::LoadField: {
-      if (!ctx || !ctx->layout_map) return FfiType::Void;
-      auto it = ctx->layout_map->find(expr->load_field_struct);
-      if (it == ctx->layout_map->end()) return FfiType::Void;
-      for (const auto& f : it->second.fields)
-        if (f.first == expr->load_field_field) return f.second.type;
-      return FfiType::Void;
-    }
-    case Expr::Kind::FieldAccess: {
-      if (!ctx || !ctx->layout_map || expr->field_chain.empty()) return FfiType::Void;
-      // Use annotated struct name if available, else derive
-      std::string struct_name = expr->load_field_struct;
-      if (struct_name.empty()) struct_name = expr_struct_name(expr->left.get(), ctx);
-      if (struct_name.empty()) return FfiType::Void;
-      std::string cur = struct_name;
-      for (size_t fi = 0; fi < expr->field_chain.size(); ++fi) {
-        auto it = ctx->layout_map->find(cur);
-        if (it == ctx->layout_map->end()) return FfiType::Void;
-        const std::string& field = expr->field_chain[fi];
-        bool found = false;
-        for (const auto& f : it->second.fields) {
-          if (f.first == field) {
-            if (fi + 1 < expr->field_chain.size()) {
-              cur = f.second.struct_name;
-            } else {
-              // Last field
-              return f.second.struct_name.empty() ? f.second.type : FfiType::Ptr;
-            }
-            found = true;
-            break;
-          }
-        }
-        if (!found) return FfiType::Void;
-      }
-      return FfiType::Void;
+static bool check_compare(Expr* expr, SemaContext& ctx) {
+  if (!expr->left || !expr->right) return false;
+  if (!check_expr(expr->left.get(), ctx) || !check_expr(expr->right.get(), ctx)) return false;
+  FfiType l = expr_type(expr->left.get(), &ctx);
+  FfiType r = expr_type(expr->right.get(), &ctx);
+  if (l == FfiType::Ptr && r == FfiType::Ptr) {
+    if (expr->compare_op != CompareOp::Eq && expr->compare_op != CompareOp::Ne) {
+      set_error(ctx, "pointer comparison only supports == and !=");
+      return false;
     }
-    case Expr::Kind::Cast:
-      if (expr->var_name == "ptr" || expr->var_name == "char") return FfiType::Ptr;
-      if (expr->var_name == "i64") return FfiType::I64;
-      if (expr->var_name == "i32") return FfiType::I32;
-      if (expr->var_name == "f64") return FfiType::F64;
-      if (expr->var_name == "f32") return FfiType::F32;
-      if (ctx && ctx->program) {
-        for (const auto& s : ctx->program->struct_defs)
-          if (s.name == expr->var_name) return FfiType::Ptr;
-      }
-      return FfiType::Void;
-    case Expr::Kind::Compare:
-      return FfiType::I64;  /* condition type as i64 0/1 for codegen */
-    case Expr::Kind::Index: {
-      FfiType elem = get_array_element_type(expr->left.get(), ctx);
-      return (elem != FfiType::Void) ? elem : FfiType::I64;
+    return true;
+  }
+  bool numeric = both_in_class(kCompareNumericMask, l, r);
+  if (!numeric) {
+    set_error(ctx, "comparison operands must be numeric (i64 or f64)");
+    return false;
+  }
+  return true;
+}
+
+using CheckFn = bool (*)(Expr*, SemaContext&);
+
+/* One entry per Expr::Kind, in declaration order. */
+constexpr size_t kExprKindCount = static_cast<size_t>(Expr::Kind::Index) + 1;
+static constexpr std::array<CheckFn, kExprKindCount> kCheckTable = {
+  &check_int_literal,     // IntLiteral
+  &check_float_literal,   // FloatLiteral
+  &check_string_literal,  // StringLiteral
+  &check_binary_op,       // BinaryOp
+  &check_call,            // Call
+  &check_var_ref,         // VarRef
+  &check_alloc,           // StackAlloc
+  &check_alloc,           // HeapAlloc
+  &check_array_alloc,     // StackArray
+  &check_array_alloc,     // HeapArray
+  &check_free,            // Free
+  &check_free_array,      // FreeArray
+  &check_as_cast,         // AsHeap
+  &check_as_cast,         // AsArray
+  &check_addr_of,         // AddrOf
+  &check_load,            // Load
+  &check_load,            // LoadF64
+  &check_load,            // LoadI32
+  &check_load,            // LoadPtr
+  &check_store,           // Store
+  &check_load_field,      // LoadField
+  &check_store_field,     // StoreField
+  &check_field_access,    // FieldAccess
+  &check_cast,            // Cast
+  &check_compare,         // Compare
+  &check_index,           // Index
+};
+
+static bool check_expr(Expr* expr, SemaContext& ctx) {
+  if (FUSION_UNLIKELY(!expr)) return false;
+  if (expr->line > 0) {
+    ctx.err->line = expr->line;
+    ctx.err->column = expr->column;
+  }
+  /* Literal leaves dominate real ASTs and can never fail; settle them here
+   * without the indirect call. The three literal kinds lead the enum. */
+  if (expr->kind <= Expr::Kind::StringLiteral) {
+    if (expr->kind == Expr::Kind::StringLiteral)
+      expr->inferred_ptr_element = "char";
+    return true;
+  }
+  /* A node that already checked clean this run stays clean; the facts the
+   * check stamped on it (inferred types, ptr elements) are still there. */
+  if (expr->checked) return true;
+  if (!kCheckTable[static_cast<size_t>(expr->kind)](expr, ctx)) return false;
+  expr->checked = 1;
+  return true;
+}
+
+/* Per-kind typers for expr_type; dispatched through kTypeTable below. */
+static FfiType type_int_literal(Expr* expr, SemaContext* ctx) {
+  return FfiType::I64;
+}
+
+static FfiType type_float_literal(Expr* expr, SemaContext* ctx) {
+  return FfiType::F64;
+}
+
+static FfiType type_string_literal(Expr* expr, SemaContext* ctx) {
+  return FfiType::Ptr;
+}
+
+static FfiType type_binary_op(Expr* expr, SemaContext* ctx) {
+  /* Iterative over the left spine, mirroring check_binary_op (including the
+   * reused thread-local buffer and its re-entrancy discipline). */
+  static thread_local std::vector<Expr*> spine;
+  if (spine.capacity() == 0) spine.reserve(64);
+  const size_t base = spine.size();
+  Expr* n = expr;
+  /* A memoized node ends the descent: its subtree is already typed. */
+  while (n->kind == Expr::Kind::BinaryOp && n->cached_type == 0xFF) {
+    spine.push_back(n);
+    n = n->left.get();
+  }
+  FfiType l = expr_type(n, ctx);
+  for (size_t i = spine.size(); i > base; --i) {
+    l = binary_result_type(spine[i - 1]->bin_op, l, expr_type(spine[i - 1]->right.get(), ctx));
+    /* Memoize interior spine nodes too, not just the root the expr_type
+     * wrapper caches, so a later query of any subchain is a byte load. */
+    if (ctx) spine[i - 1]->cached_type = static_cast<uint8_t>(l);
+  }
+  spine.resize(base);
+  return l;
+}
+
+static FfiType type_call(Expr* expr, SemaContext* ctx) {
+  if (!ctx) {
+    /* No pool without a context; fall back to the shared string table. */
+    if (auto bt = builtin_fixed_return_type(expr->callee)) return *bt;
+    return FfiType::Void;
+  }
+  Builtin b = classify_builtin(expr, *ctx);
+  if (b == Builtin::Call) {
+    if (expr->args.size() >= 1)
+      if (const FnPtrSig* sig = lookup_fnptr_sig(ctx, expr->args[0].get()))
+        return sig->result;
+    if (!expr->inferred_call_param_types.empty())
+      return expr->inferred_call_result_type;
+    return FfiType::Void;
+  }
+  if (b == Builtin::FromStr) {
+    if (expr->call_type_arg == "i64") return FfiType::I64;
+    if (expr->call_type_arg == "f64") return FfiType::F64;
+    return FfiType::Void;
+  }
+  if (b != Builtin::None) return kBuiltinReturnType[static_cast<size_t>(b)];
+  const CalleeInfo* info = callee_info(expr, expr->callee, ctx);
+  if (info && info->known()) return info->sig.result;
+  return FfiType::Void;
+}
+
+static FfiType type_var_ref(Expr* expr, SemaContext* ctx) {
+  if (ctx) {
+    FfiType ty;
+    if (var_type_lookup(ctx, expr->var_name, &ty)) return ty;
+  }
+  return FfiType::Void;
+}
+
+static FfiType type_ptr_result(Expr* expr, SemaContext* ctx) {
+  return FfiType::Ptr;
+}
+
+static FfiType type_void_result(Expr* expr, SemaContext* ctx) {
+  return FfiType::Void;
+}
+
+static FfiType type_i64_result(Expr* expr, SemaContext* ctx) {
+  return FfiType::I64;
+}
+
+static FfiType type_f64_result(Expr* expr, SemaContext* ctx) {
+  return FfiType::F64;
+}
+
+static FfiType type_load_field(Expr* expr, SemaContext* ctx) {
+  if (const FieldLayout* f = lookup_field(expr->load_field_struct, expr->load_field_field, ctx))
+    return f->type;
+  return FfiType::Void;
+}
+
+static FfiType type_field_access(Expr* expr, SemaContext* ctx) {
+  if (!ctx || !ctx->layout_map || expr->field_chain.empty()) return FfiType::Void;
+  // Use annotated struct name if available, else derive
+  std::string struct_name = expr->load_field_struct;
+  if (struct_name.empty()) struct_name = expr_struct_name(expr->left.get(), ctx);
+  if (struct_name.empty()) return FfiType::Void;
+  std::string cur = struct_name;
+  for (size_t fi = 0; fi < expr->field_chain.size(); ++fi) {
+    auto it = ctx->layout_map->find(cur);
+    if (it == ctx->layout_map->end()) return FfiType::Void;
+    const std::string& field = expr->field_chain[fi];
+    bool found = false;
+    if (const FieldLayout* f = it->second.find_field(field)) {
+      if (fi + 1 < expr->field_chain.size()) {
+        cur = f->struct_name;
+      } else {
+        // Last field
+        return f->struct_name.empty() ? f->type : FfiType::Ptr;
+      }
+      found = true;
     }
+    if (!found) return FfiType::Void;
   }
   return FfiType::Void;
 }
 
-static bool is_named_type_known(const std::string& name, Program* program) {
-  if (name == "char") return true;  // char is valid as ptr element type
-  for (const std::string& o : program->opaque_types)
-    if (o == name) return true;
-  for (const auto& s : program->struct_defs)
-    if (s.name == name) return true;
-  return false;
+static FfiType type_cast(Expr* expr, SemaContext* ctx) {
+  switch (pack_type_name(expr->var_name)) {
+    case pack_type_name("ptr", 3):
+    case pack_type_name("char", 4): return FfiType::Ptr;
+    case pack_type_name("i64", 3): return FfiType::I64;
+    case pack_type_name("i32", 3): return FfiType::I32;
+    case pack_type_name("f64", 3): return FfiType::F64;
+    case pack_type_name("f32", 3): return FfiType::F32;
+    default: break;
+  }
+  if (ctx && ctx->struct_names && ctx->struct_names->contains(expr->var_name))
+    return FfiType::Ptr;
+  return FfiType::Void;
+}
+
+static FfiType type_compare(Expr* expr, SemaContext* ctx) {
+  return FfiType::I64;  /* condition type as i64 0/1 for codegen */
+}
+
+static FfiType type_index(Expr* expr, SemaContext* ctx) {
+  FfiType elem = get_array_element_type(expr->left.get(), ctx);
+  return (elem != FfiType::Void) ? elem : FfiType::I64;
+}
+
+using TypeFn = FfiType (*)(Expr*, SemaContext*);
+
+/* One entry per Expr::Kind, in declaration order. */
+static constexpr std::array<TypeFn, kExprKindCount> kTypeTable = {
+  &type_int_literal,      // IntLiteral
+  &type_float_literal,    // FloatLiteral
+  &type_string_literal,   // StringLiteral
+  &type_binary_op,        // BinaryOp
+  &type_call,             // Call
+  &type_var_ref,          // VarRef
+  &type_ptr_result,       // StackAlloc
+  &type_ptr_result,       // HeapAlloc
+  &type_ptr_result,       // StackArray
+  &type_ptr_result,       // HeapArray
+  &type_void_result,      // Free
+  &type_void_result,      // FreeArray
+  &type_ptr_result,       // AsHeap
+  &type_ptr_result,       // AsArray
+  &type_ptr_result,       // AddrOf
+  &type_i64_result,       // Load
+  &type_f64_result,       // LoadF64
+  &type_i64_result,       // LoadI32
+  &type_ptr_result,       // LoadPtr
+  &type_void_result,      // Store
+  &type_load_field,       // LoadField
+  &type_void_result,      // StoreField
+  &type_field_access,     // FieldAccess
+  &type_cast,             // Cast
+  &type_compare,          // Compare
+  &type_index,            // Index
+};
+
+static FfiType expr_type(Expr* expr, SemaContext* ctx) {
+  if (FUSION_UNLIKELY(!expr)) return FfiType::Void;
+  /* Same literal fast path as check_expr: leaves are the common case. */
+  switch (expr->kind) {
+    case Expr::Kind::IntLiteral: return FfiType::I64;
+    case Expr::Kind::FloatLiteral: return FfiType::F64;
+    case Expr::Kind::StringLiteral: return FfiType::Ptr;
+    default: break;
+  }
+  /* A node's static type is fixed for the run, so memoize it on the node;
+   * check-then-type and shared subtree walks hit the cache. Only a typing
+   * with full context is worth remembering. */
+  if (FUSION_LIKELY(expr->cached_type != 0xFF)) return static_cast<FfiType>(expr->cached_type);
+  FfiType t = kTypeTable[static_cast<size_t>(expr->kind)](expr, ctx);
+  if (ctx) expr->cached_type = static_cast<uint8_t>(t);
+  return t;
+}
+
+static bool is_named_type_known(const std::string& name, const SemaContext* ctx) {
+  if (pack_type_name(name) == pack_type_name("char", 4)) return true;  // valid as ptr element type
+  return ctx && ctx->named_types && ctx->named_types->contains(name);
 }
 
 /* Valid for ptr[T] return / array element: primitives (i8, i32, i64, f32, f64, char) or known struct/opaque. */
-static bool is_valid_array_element_type(const std::string& name, Program* program) {
-  if (name == "char" || name == "i8" || name == "i32" || name == "i64" || name == "f32" || name == "f64")
-    return true;
-  return program && is_named_type_known(name, program);
+static bool is_valid_array_element_type(const std::string& name, const SemaContext* ctx) {
+  switch (pack_type_name(name)) {
+    case pack_type_name("char", 4):
+    case pack_type_name("i8", 2):
+    case pack_type_name("i32", 3):
+    case pack_type_name("i64", 3):
+    case pack_type_name("f32", 3):
+    case pack_type_name("f64", 3):
+      return true;
+    default:
+      return ctx && ctx->named_types && ctx->named_types->contains(name);
+  }
+}
+
+/* Push/pop one frame, recycling retired frames (and their entry storage)
+ * through the per-stack spare pool instead of reallocating each scope. */
+template <typename V>
+static void frame_push(std::vector<SmallScopeMap<V>>& stack,
+                       std::vector<SmallScopeMap<V>>& spare) {
+  if (spare.empty()) {
+    stack.emplace_back();
+  } else {
+    spare.back().clear();
+    stack.push_back(std::move(spare.back()));
+    spare.pop_back();
+  }
+}
+
+template <typename V>
+static void frame_pop(std::vector<SmallScopeMap<V>>& stack,
+                      std::vector<SmallScopeMap<V>>& spare) {
+  spare.push_back(std::move(stack.back()));
+  stack.pop_back();
+}
+
+/* Reserve the outer stacks for the expected block depth so early pushes do
+ * not regrow eight vectors one frame at a time. */
+static void scope_reserve(SemaContext& ctx, size_t depth) {
+  ctx.var_scope_stack.reserve(depth);
+  ctx.array_element_scope_stack.reserve(depth);
+  ctx.fnptr_scope_stack.reserve(depth);
+  ctx.var_flavor_scope_stack.reserve(depth);
+  ctx.var_base_scope_stack.reserve(depth);
+  ctx.var_struct_scope_stack.reserve(depth);
+  ctx.array_struct_scope_stack.reserve(depth);
+  ctx.var_ptr_element_scope_stack.reserve(depth);
 }
 
 static void scope_push(SemaContext& ctx) {
-  ctx.var_scope_stack.push_back({});
-  ctx.array_element_scope_stack.push_back({});
-  ctx.fnptr_scope_stack.push_back({});
-  ctx.var_flavor_scope_stack.push_back({});
-  ctx.var_base_scope_stack.push_back({});
-  ctx.var_struct_scope_stack.push_back({});
-  ctx.array_struct_scope_stack.push_back({});
-  ctx.var_ptr_element_scope_stack.push_back({});
+  frame_push(ctx.var_scope_stack, ctx.var_scope_spare);
+  frame_push(ctx.array_element_scope_stack, ctx.array_element_scope_spare);
+  frame_push(ctx.fnptr_scope_stack, ctx.fnptr_scope_spare);
+  frame_push(ctx.var_flavor_scope_stack, ctx.var_flavor_scope_spare);
+  frame_push(ctx.var_base_scope_stack, ctx.var_base_scope_spare);
+  frame_push(ctx.var_struct_scope_stack, ctx.var_struct_scope_spare);
+  frame_push(ctx.array_struct_scope_stack, ctx.array_struct_scope_spare);
+  frame_push(ctx.var_ptr_element_scope_stack, ctx.var_ptr_element_scope_spare);
 }
 
 static void scope_pop(SemaContext& ctx) {
-  ctx.var_scope_stack.pop_back();
-  ctx.array_element_scope_stack.pop_back();
-  ctx.fnptr_scope_stack.pop_back();
-  ctx.var_flavor_scope_stack.pop_back();
-  ctx.var_base_scope_stack.pop_back();
-  ctx.var_struct_scope_stack.pop_back();
-  ctx.array_struct_scope_stack.pop_back();
-  ctx.var_ptr_element_scope_stack.pop_back();
+  frame_pop(ctx.var_scope_stack, ctx.var_scope_spare);
+  frame_pop(ctx.array_element_scope_stack, ctx.array_element_scope_spare);
+  frame_pop(ctx.fnptr_scope_stack, ctx.fnptr_scope_spare);
+  frame_pop(ctx.var_flavor_scope_stack, ctx.var_flavor_scope_spare);
+  frame_pop(ctx.var_base_scope_stack, ctx.var_base_scope_spare);
+  frame_pop(ctx.var_struct_scope_stack, ctx.var_struct_scope_spare);
+  frame_pop(ctx.array_struct_scope_stack, ctx.array_struct_scope_spare);
+  frame_pop(ctx.var_ptr_element_scope_stack, ctx.var_ptr_element_scope_spare);
 }
 
 static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt);
 
+/* Pushes one scope frame for its lifetime; the destructor pops it on every
+ * exit path, so block checks cannot leak or double-pop frames. */
+struct ScopeGuard {
+  SemaContext& ctx;
+  explicit ScopeGuard(SemaContext& ctx) : ctx(ctx) { scope_push(ctx); }
+  ~ScopeGuard() { scope_pop(ctx); }
+  ScopeGuard(const ScopeGuard&) = delete;
+  ScopeGuard& operator=(const ScopeGuard&) = delete;
+};
+
 static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
   if (!stmt) return false;
   switch (stmt->kind) {
-    case Stmt::Kind::Return:
+    case Stmt::Kind::Return: {
       if (!def) {
-        ctx.err->message = "return only allowed inside a function";
+        set_error(ctx, "return only allowed inside a function");
         return false;
       }
       ctx.has_expected_return_type = true;
       ctx.expected_return_type = def->return_type;
-      if (!check_expr(stmt->expr.get(), ctx)) {
-        ctx.has_expected_return_type = false;
-        return false;
-      }
+      CheckedType ret = check_and_type(stmt->expr.get(), ctx);
       ctx.has_expected_return_type = false;
-      if (expr_type(stmt->expr.get(), &ctx) != def->return_type) {
-        ctx.err->message = "return type does not match function return type in '" + def->name + "'";
+      if (!ret.ok) return false;
+      if (ret.ty != def->return_type) {
+        set_error(ctx, "return type does not match function return type in '", def->name, "'");
         return false;
       }
       if (def->return_type == FfiType::Ptr && is_stack_ptr(expr_flavor(stmt->expr.get(), &ctx))) {
-        ctx.err->message = "cannot return stack pointer (stack allocation escapes)";
+        set_error(ctx, "cannot return stack pointer (stack allocation escapes)");
         return false;
       }
       return true;
+    }
     case Stmt::Kind::Let: {
-      if (!check_expr(stmt->init.get(), ctx)) return false;
-      if (ctx.var_scope_stack.empty() || ctx.var_scope_stack.back().count(stmt->name)) {
-        ctx.err->message = def
-          ? "duplicate variable '" + stmt->name + "' in function '" + def->name + "'"
-          : "duplicate variable '" + stmt->name + "'";
+      CheckedType init = check_and_type(stmt->init.get(), ctx);
+      if (!init.ok) return false;
+      FfiType* let_slot = ctx.var_scope_stack.empty()
+          ? nullptr : ctx.var_scope_stack.back().try_emplace(stmt->name);
+      if (!let_slot) {
+        if (def)
+          set_error(ctx, "duplicate variable '", stmt->name, "' in function '", def->name, "'");
+        else
+          set_error(ctx, "duplicate variable '", stmt->name, "'");
         return false;
       }
-      FfiType let_ty = expr_type(stmt->init.get(), &ctx);
-      ctx.var_scope_stack.back()[stmt->name] = let_ty;
+      FfiType let_ty = init.ty;
+      *let_slot = let_ty;
       AllocFlavor let_flavor = expr_flavor(stmt->init.get(), &ctx);
       PtrBase let_base = (let_ty == FfiType::Ptr) ? expr_base(stmt->init.get(), &ctx) : PtrBase::Unknown;
       if (!ctx.var_flavor_scope_stack.empty())
@@ -1287,9 +1948,10 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
       if (!ctx.var_base_scope_stack.empty())
         ctx.var_base_scope_stack.back()[stmt->name] = let_base;
       if (let_ty == FfiType::Ptr && !ctx.fnptr_scope_stack.empty()) {
-        FnPtrSig sig;
-        if (lookup_fnptr_sig(&ctx, stmt->init.get(), &sig))
-          ctx.fnptr_scope_stack.back()[stmt->name] = sig;
+        if (const FnPtrSig* sig = lookup_fnptr_sig(&ctx, stmt->init.get())) {
+          FnPtrSig copy = *sig;  // sig may point into the frame the insert grows
+          ctx.fnptr_scope_stack.back()[stmt->name] = std::move(copy);
+        }
       }
       // Track ptr-to-struct
       if (let_ty == FfiType::Ptr && !ctx.var_struct_scope_stack.empty()) {
@@ -1303,19 +1965,18 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
           std::string base_struct = expr_struct_name(fa->left.get(), &ctx);
           if (base_struct.empty() && fa->left->kind == Expr::Kind::VarRef)
             base_struct = var_ptr_element_lookup(&ctx, fa->left->var_name);
-          if (!base_struct.empty() && ctx.program && is_named_type_known(base_struct, ctx.program)) {
+          if (!base_struct.empty() && ctx.program && is_named_type_known(base_struct, &ctx)) {
             for (const std::string& fname : fa->field_chain) {
               auto it = ctx.layout_map->find(base_struct);
               if (it == ctx.layout_map->end()) break;
-              for (const auto& f : it->second.fields) {
-                if (f.first == fname) { base_struct = f.second.struct_name; break; }
-              }
+              if (const FieldLayout* f = it->second.find_field(fname))
+                base_struct = f->struct_name;
             }
             if (!base_struct.empty()) sname = base_struct;
           }
         }
         if (sname.empty() && stmt->init && !stmt->init->inferred_ptr_element.empty() &&
-            ctx.program && is_named_type_known(stmt->init->inferred_ptr_element, ctx.program))
+            ctx.program && is_named_type_known(stmt->init->inferred_ptr_element, &ctx))
           sname = stmt->init->inferred_ptr_element;
         if (!sname.empty()) {
           ctx.var_struct_scope_stack.back()[stmt->name] = sname;
@@ -1334,17 +1995,14 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
             auto it = ctx.layout_map->find(cur);
             if (it == ctx.layout_map->end()) break;
             bool found = false;
-            for (const auto& f : it->second.fields) {
-              if (f.first == e->field_chain[fi]) {
-                if (fi + 1 == e->field_chain.size() && f.second.type == FfiType::Ptr) {
-                  ctx.array_element_scope_stack.back()[stmt->name] = FfiType::Ptr;
-                  if (!f.second.struct_name.empty() && !ctx.array_struct_scope_stack.empty())
-                    ctx.array_struct_scope_stack.back()[stmt->name] = f.second.struct_name;
-                }
-                cur = f.second.struct_name.empty() ? cur : f.second.struct_name;
-                found = true;
-                break;
+            if (const FieldLayout* f = it->second.find_field(e->field_chain[fi])) {
+              if (fi + 1 == e->field_chain.size() && f->type == FfiType::Ptr) {
+                ctx.array_element_scope_stack.back()[stmt->name] = FfiType::Ptr;
+                if (!f->struct_name.empty() && !ctx.array_struct_scope_stack.empty())
+                  ctx.array_struct_scope_stack.back()[stmt->name] = f->struct_name;
               }
+              cur = f->struct_name.empty() ? cur : f->struct_name;
+              found = true;
             }
             if (!found) break;
           }
@@ -1358,12 +2016,8 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
           const std::string& t = init->var_name;
           if (t.size() > 5 && t.substr(0,4) == "ptr[" && t.back() == ']')
             ctx.array_struct_scope_stack.back()[stmt->name] = t.substr(4, t.size()-5);
-          else
-            for (const auto& s : ctx.program->struct_defs)
-              if (s.name == t) {
-                ctx.array_struct_scope_stack.back()[stmt->name] = t;
-                break;
-              }
+          else if (ctx.struct_names && ctx.struct_names->contains(t))
+            ctx.array_struct_scope_stack.back()[stmt->name] = t;
         } else if (init && init->kind == Expr::Kind::Call && let_ty == FfiType::Ptr) {
           std::string elem_struct = get_call_array_element_struct(init, &ctx);
           if (!elem_struct.empty())
@@ -1380,64 +2034,64 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
     }
     case Stmt::Kind::Expr:
       return check_expr(stmt->expr.get(), ctx);
-    case Stmt::Kind::If:
+    case Stmt::Kind::If: {
       if (!check_expr(stmt->cond.get(), ctx)) return false;
-      scope_push(ctx);
-      for (StmtPtr& s : stmt->then_body)
-        if (!check_stmt(ctx, def, s.get())) { scope_pop(ctx); return false; }
-      scope_pop(ctx);
+      {
+        ScopeGuard then_scope(ctx);
+        for (StmtPtr& s : stmt->then_body)
+          if (!check_stmt(ctx, def, s.get())) return false;
+      }
       if (stmt->else_body.empty()) return true;
-      scope_push(ctx);
+      ScopeGuard else_scope(ctx);
       for (StmtPtr& s : stmt->else_body)
-        if (!check_stmt(ctx, def, s.get())) { scope_pop(ctx); return false; }
-      scope_pop(ctx);
+        if (!check_stmt(ctx, def, s.get())) return false;
       return true;
+    }
     case Stmt::Kind::For: {
       if (!stmt->cond) return false;
-      scope_push(ctx);
+      ScopeGuard for_scope(ctx);
       if (stmt->for_init) {
         if (stmt->for_init->kind == Stmt::Kind::Let) {
-          if (!check_expr(stmt->for_init->init.get(), ctx)) { scope_pop(ctx); return false; }
-          if (ctx.var_scope_stack.back().count(stmt->for_init->name)) {
-            ctx.err->message = def
-              ? "duplicate variable '" + stmt->for_init->name + "' in function '" + def->name + "'"
-              : "duplicate variable '" + stmt->for_init->name + "'";
-            scope_pop(ctx);
+          CheckedType init = check_and_type(stmt->for_init->init.get(), ctx);
+          if (!init.ok) return false;
+          FfiType* init_slot = ctx.var_scope_stack.back().try_emplace(stmt->for_init->name);
+          if (!init_slot) {
+            if (def)
+              set_error(ctx, "duplicate variable '", stmt->for_init->name, "' in function '", def->name, "'");
+            else
+              set_error(ctx, "duplicate variable '", stmt->for_init->name, "'");
             return false;
           }
-          ctx.var_scope_stack.back()[stmt->for_init->name] = expr_type(stmt->for_init->init.get(), &ctx);
+          *init_slot = init.ty;
           AllocFlavor init_flavor = expr_flavor(stmt->for_init->init.get(), &ctx);
-          PtrBase init_base = (expr_type(stmt->for_init->init.get(), &ctx) == FfiType::Ptr)
+          PtrBase init_base = (init.ty == FfiType::Ptr)
             ? expr_base(stmt->for_init->init.get(), &ctx) : PtrBase::Unknown;
           ctx.var_flavor_scope_stack.back()[stmt->for_init->name] = init_flavor;
           ctx.var_base_scope_stack.back()[stmt->for_init->name] = init_base;
         } else if (stmt->for_init->kind == Stmt::Kind::Assign) {
-          if (!check_stmt(ctx, def, stmt->for_init.get())) { scope_pop(ctx); return false; }
+          if (!check_stmt(ctx, def, stmt->for_init.get())) return false;
         }
       }
-      if (!check_expr(stmt->cond.get(), ctx)) { scope_pop(ctx); return false; }
+      if (!check_expr(stmt->cond.get(), ctx)) return false;
       if (stmt->for_update) {
-        if (stmt->for_update->kind != Stmt::Kind::Assign || !check_stmt(ctx, def, stmt->for_update.get())) {
-          scope_pop(ctx);
+        if (stmt->for_update->kind != Stmt::Kind::Assign || !check_stmt(ctx, def, stmt->for_update.get()))
           return false;
-        }
       }
       for (StmtPtr& s : stmt->body)
-        if (!check_stmt(ctx, def, s.get())) { scope_pop(ctx); return false; }
-      scope_pop(ctx);
+        if (!check_stmt(ctx, def, s.get())) return false;
       return true;
     }
     case Stmt::Kind::Assign: {
       if (!stmt->expr || !stmt->init) return false;
-      if (!check_expr(stmt->expr.get(), ctx) || !check_expr(stmt->init.get(), ctx)) return false;
+      CheckedType target = check_and_type(stmt->expr.get(), ctx);
+      if (!target.ok) return false;
+      CheckedType value = check_and_type(stmt->init.get(), ctx);
+      if (!value.ok) return false;
       if (stmt->expr->kind == Expr::Kind::VarRef) {
-        FfiType var_ty = expr_type(stmt->expr.get(), &ctx);
-        FfiType val_ty = expr_type(stmt->init.get(), &ctx);
-        bool compat = (var_ty == val_ty) ||
-          (var_ty == FfiType::Ptr && val_ty == FfiType::I64) ||
-          (var_ty == FfiType::I64 && val_ty == FfiType::Ptr);
-        if (!compat) {
-          ctx.err->message = "assignment type mismatch";
+        FfiType var_ty = target.ty;
+        FfiType val_ty = value.ty;
+        if (!compat_ok(kAssignCompat, var_ty, val_ty)) {
+          set_error(ctx, "assignment type mismatch");
           return false;
         }
         if (var_ty == FfiType::Ptr && val_ty == FfiType::Ptr) {
@@ -1445,9 +2099,10 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
           PtrBase val_base = expr_base(stmt->init.get(), &ctx);
           update_var_flavor_base(&ctx, stmt->expr->var_name, val_flavor, val_base);
           if (!ctx.fnptr_scope_stack.empty()) {
-            FnPtrSig sig;
-            if (lookup_fnptr_sig(&ctx, stmt->init.get(), &sig))
-              ctx.fnptr_scope_stack.back()[stmt->expr->var_name] = sig;
+            if (const FnPtrSig* sig = lookup_fnptr_sig(&ctx, stmt->init.get())) {
+              FnPtrSig copy = *sig;  // sig may point into the frame the insert grows
+              ctx.fnptr_scope_stack.back()[stmt->expr->var_name] = std::move(copy);
+            }
           }
         }
         return true;
@@ -1456,18 +2111,14 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
         FfiType elem_ty = get_array_element_type(stmt->expr->left.get(), &ctx);
         if (elem_ty == FfiType::Void) elem_ty = FfiType::I64;
         FfiType val_ty = expr_type(stmt->init.get(), &ctx);
-        bool compat = (elem_ty == val_ty) ||
-          (elem_ty == FfiType::Ptr && val_ty == FfiType::I64) ||
-          (elem_ty == FfiType::I64 && val_ty == FfiType::Ptr) ||
-          (elem_ty == FfiType::I8 && val_ty == FfiType::I64);
-        if (!compat) {
-          ctx.err->message = "assignment type mismatch for array element";
+        if (!compat_ok(kElemAssignCompat, elem_ty, val_ty)) {
+          set_error(ctx, "assignment type mismatch for array element");
           return false;
         }
         if (elem_ty == FfiType::Ptr && val_ty == FfiType::Ptr &&
             is_stack_ptr(expr_flavor(stmt->init.get(), &ctx)) &&
             may_outlive_function(expr_base(stmt->expr->left.get(), &ctx))) {
-          ctx.err->message = "cannot store stack pointer into array that may outlive function";
+          set_error(ctx, "cannot store stack pointer into array that may outlive function");
           return false;
         }
         return true;
@@ -1475,75 +2126,88 @@ static bool check_stmt(SemaContext& ctx, FnDef* def, Stmt* stmt) {
       if (stmt->expr->kind == Expr::Kind::FieldAccess) {
         FfiType field_ty = expr_type(stmt->expr.get(), &ctx);
         FfiType val_ty = expr_type(stmt->init.get(), &ctx);
-        bool compat = (field_ty == val_ty) ||
-          (field_ty == FfiType::Ptr && val_ty == FfiType::I64) ||
-          (field_ty == FfiType::I64 && val_ty == FfiType::Ptr) ||
-          (field_ty == FfiType::F64 && val_ty == FfiType::I64) ||
-          (field_ty == FfiType::I64 && val_ty == FfiType::F64);
-        if (!compat) {
-          ctx.err->message = "field assignment: value type does not match field type";
+        if (!compat_ok(kFieldAssignCompat, field_ty, val_ty)) {
+          set_error(ctx, "field assignment: value type does not match field type");
           return false;
         }
         if (field_ty == FfiType::Ptr && val_ty == FfiType::Ptr &&
             is_stack_ptr(expr_flavor(stmt->init.get(), &ctx)) &&
             may_outlive_function(expr_base(stmt->expr->left.get(), &ctx))) {
-          ctx.err->message = "cannot store stack pointer into memory that may outlive function";
+          set_error(ctx, "cannot store stack pointer into memory that may outlive function");
           return false;
         }
         return true;
       }
-      ctx.err->message = "assignment target must be a variable, index, or field access";
+      set_error(ctx, "assignment target must be a variable, index, or field access");
       return false;
     }
   }
   return false;
 }
 
-static bool check_fn_def(SemaContext& ctx, FnDef& def) {
-  if (!def.array_element_struct.empty() && !is_valid_array_element_type(def.array_element_struct, ctx.program)) {
-    ctx.err->message = "unknown array element struct '" + def.array_element_struct + "' in fn '" + def.name + "'";
+/* err is passed explicitly (not taken from ctx) so function bodies can be
+ * checked concurrently, each worker writing into its own error slot. */
+static bool check_fn_def(SemaContext& ctx, FnDef& def, SemaError* err) {
+  if (!def.array_element_struct.empty() && !is_valid_array_element_type(def.array_element_struct, &ctx)) {
+    set_error(err, "unknown array element struct '", def.array_element_struct, "' in fn '", def.name, "'");
     return false;
   }
-  std::unordered_map<std::string, FfiType> local;
-  std::unordered_map<std::string, FfiType> array_local;
-  std::unordered_map<std::string, AllocFlavor> param_flavor;
-  std::unordered_map<std::string, PtrBase> param_base;
+  /* One context per thread, reused across function bodies: the global name
+   * tables (symbols, callees, named types, layouts) are shared read-only
+   * pointers, so only the parameter scope built below is per-function state.
+   * Retiring leftover frames into the spare pools (instead of destroying the
+   * context) means a failed check, which returns with frames still on the
+   * stacks, donates their storage to the next function too. thread_local is
+   * what keeps the parallel phase below data-race free. */
+  thread_local SemaContext fn_ctx;
+  while (!fn_ctx.var_scope_stack.empty()) scope_pop(fn_ctx);
+  fn_ctx.has_expected_return_type = false;
+  fn_ctx.expected_return_type = FfiType::Void;
+  scope_reserve(fn_ctx, 8);
+  fn_ctx.err = err;
+  fn_ctx.layout_map = ctx.layout_map;
+  fn_ctx.program = ctx.program;
+  fn_ctx.named_types = ctx.named_types;
+  fn_ctx.struct_names = ctx.struct_names;
+  fn_ctx.symbols = ctx.symbols;
+  fn_ctx.callees = ctx.callees;
+  scope_push(fn_ctx);
+  SmallScopeMap<FfiType>& local = fn_ctx.var_scope_stack.back();
+  SmallScopeMap<FfiType>& array_local = fn_ctx.array_element_scope_stack.back();
+  SmallScopeMap<AllocFlavor>& param_flavor = fn_ctx.var_flavor_scope_stack.back();
+  SmallScopeMap<PtrBase>& param_base = fn_ctx.var_base_scope_stack.back();
+  /* Top-level lets in the body are a cheap upper bound for locals entering
+   * this scope, so the entries vector never regrows mid-check. */
+  size_t let_count = 0;
+  for (const StmtPtr& st : def.body)
+    if (st && st->kind == Stmt::Kind::Let) ++let_count;
+  local.reserve(def.params.size() + let_count);
+  array_local.reserve(def.params.size());
+  param_flavor.reserve(def.params.size());
+  param_base.reserve(def.params.size());
   for (size_t j = 0; j < def.params.size(); ++j) {
     local[def.params[j].first] = def.params[j].second;
     param_flavor[def.params[j].first] = AllocFlavor::Unknown;
     param_base[def.params[j].first] = PtrBase::Param;
+    if (def.params[j].second == FfiType::Ptr)
+      array_local[def.params[j].first] = FfiType::Ptr;
   }
-  for (const auto& p : def.params)
-    if (p.second == FfiType::Ptr)
-      array_local[p.first] = FfiType::Ptr;
-  SemaContext fn_ctx;
-  fn_ctx.err = ctx.err;
-  fn_ctx.layout_map = ctx.layout_map;
-  fn_ctx.program = ctx.program;
-  fn_ctx.extern_fn_by_name = ctx.extern_fn_by_name;
-  fn_ctx.user_fn_by_name = ctx.user_fn_by_name;
-  fn_ctx.var_scope_stack.push_back(std::move(local));
-  fn_ctx.array_element_scope_stack.push_back(std::move(array_local));
-  fn_ctx.fnptr_scope_stack.push_back({});
-  fn_ctx.var_flavor_scope_stack.push_back(std::move(param_flavor));
-  fn_ctx.var_base_scope_stack.push_back(std::move(param_base));
-  std::unordered_map<std::string, std::string> param_struct;
+  SmallScopeMap<std::string>& param_struct = fn_ctx.var_struct_scope_stack.back();
+  SmallScopeMap<std::string>& param_arr_struct = fn_ctx.array_struct_scope_stack.back();
   if (ctx.program) {
     for (size_t j = 0; j < def.params.size() && j < def.param_type_names.size(); ++j) {
       if (!def.param_type_names[j].empty() &&
-          is_named_type_known(def.param_type_names[j], ctx.program))
+          is_named_type_known(def.param_type_names[j], &ctx)) {
         param_struct[def.params[j].first] = def.param_type_names[j];
+        param_arr_struct[def.params[j].first] = def.param_type_names[j];
+      }
     }
   }
-  auto param_arr_struct = param_struct;  // copy before move
-  fn_ctx.var_struct_scope_stack.push_back(std::move(param_struct));
-  fn_ctx.array_struct_scope_stack.push_back(std::move(param_arr_struct));
-  std::unordered_map<std::string, std::string> param_ptr_element;
+  SmallScopeMap<std::string>& param_ptr_element = fn_ctx.var_ptr_element_scope_stack.back();
   for (size_t j = 0; j < def.params.size() && j < def.param_type_names.size(); ++j) {
     if (!def.param_type_names[j].empty())
       param_ptr_element[def.params[j].first] = def.param_type_names[j];
   }
-  fn_ctx.var_ptr_element_scope_stack.push_back(std::move(param_ptr_element));
   for (StmtPtr& stmt : def.body) {
     if (!check_stmt(fn_ctx, &def, stmt.get())) return false;
   }
@@ -1562,175 +2226,246 @@ SemaResult check(Program* program) {
     r.errors.push_back(r.error);
     return r;
   }
-  std::unordered_set<std::string> lib_names;
+  StringTable<char> lib_names;
+  lib_names.reserve(program->libs.size());
   for (const ExternLib& lib : program->libs)
-    lib_names.insert(lib.name);
+    lib_names[lib.name] = 1;
+  /* Named-type lookups below are set probes, not vector scans. */
+  StringTable<char> named_types;
+  StringTable<char> struct_names;
+  named_types.reserve(program->opaque_types.size() + program->struct_defs.size());
+  struct_names.reserve(program->struct_defs.size());
+  for (const std::string& o : program->opaque_types)
+    named_types[o] = 1;
+  for (const StructDef& sd : program->struct_defs) {
+    named_types[sd.name] = 1;
+    struct_names[sd.name] = 1;
+  }
+  SemaContext ctx;
+  ctx.err = &r.error;
+  ctx.program = program;
+  ctx.named_types = &named_types;
+  ctx.struct_names = &struct_names;
   for (const ExternFn& ext : program->extern_fns) {
-    if (lib_names.find(ext.lib_name) == lib_names.end()) {
-      r.error.message = "extern fn '" + ext.name + "' references unknown lib '" + ext.lib_name + "'";
+    if (!lib_names.contains(ext.lib_name)) {
+      set_error(&r.error, "extern fn '", ext.name, "' references unknown lib '", ext.lib_name, "'");
       r.errors.push_back(r.error);
       return r;
     }
     bool param_names_ok = (ext.param_type_names.size() == ext.params.size());
     if (param_names_ok) {
       for (size_t j = 0; j < ext.param_type_names.size(); ++j) {
-        if (!ext.param_type_names[j].empty() && !is_named_type_known(ext.param_type_names[j], program)) {
-          r.error.message = "unknown type '" + ext.param_type_names[j] + "' in extern fn '" + ext.name + "'";
+        if (!ext.param_type_names[j].empty() && !is_named_type_known(ext.param_type_names[j], &ctx)) {
+          set_error(&r.error, "unknown type '", ext.param_type_names[j], "' in extern fn '", ext.name, "'");
           r.errors.push_back(r.error);
           return r;
         }
       }
     }
-    if (!ext.return_type_name.empty() && !is_named_type_known(ext.return_type_name, program)) {
-      r.error.message = "unknown return type '" + ext.return_type_name + "' in extern fn '" + ext.name + "'";
+    if (!ext.return_type_name.empty() && !is_named_type_known(ext.return_type_name, &ctx)) {
+      set_error(&r.error, "unknown return type '", ext.return_type_name, "' in extern fn '", ext.name, "'");
       r.errors.push_back(r.error);
       return r;
     }
-    if (!ext.array_element_struct.empty() && !is_valid_array_element_type(ext.array_element_struct, program)) {
-      r.error.message = "unknown array element struct '" + ext.array_element_struct + "' in extern fn '" + ext.name + "'";
+    if (!ext.array_element_struct.empty() && !is_valid_array_element_type(ext.array_element_struct, &ctx)) {
+      set_error(&r.error, "unknown array element struct '", ext.array_element_struct, "' in extern fn '", ext.name, "'");
       r.errors.push_back(r.error);
       return r;
     }
   }
   LayoutMap layout_map = build_layout_map(program->struct_defs);
-  SemaContext ctx;
-  ctx.err = &r.error;
   ctx.layout_map = &layout_map;
-  ctx.program = program;
+  /* Intern every callable name, then size one callee table by symbol id.
+   * Both are read-only for the rest of the run (including the parallel
+   * phase below); nodes cache their resolved id in Expr::sym. */
+  SymbolPool symbols;
+  std::vector<CalleeInfo> callees;
+  symbols.reserve(kNumBuiltins + program->extern_fns.size() + program->user_fns.size());
+  for (const char* b : kBuiltinNames)
+    symbols.intern(b);
+  for (const ExternFn& ext : program->extern_fns)
+    symbols.intern(ext.name);
+  for (const FnDef& def : program->user_fns)
+    symbols.intern(def.name);
+  callees.resize(symbols.size() + 1);
   for (const ExternFn& ext : program->extern_fns) {
-    ctx.extern_fn_by_name[ext.name] = ext;
+    CalleeInfo& ci = callees[symbols.lookup(ext.name)];
+    ci.ext = &ext;
+    ci.sig.result = ext.return_type;
+    ci.sig.params.reserve(ext.params.size());
+    for (const auto& pr : ext.params)
+      ci.sig.params.push_back(pr.second);
   }
   for (FnDef& def : program->user_fns) {
-    if (ctx.extern_fn_by_name.count(def.name)) {
-      r.error.message = "function '" + def.name + "' conflicts with extern function";
+    CalleeInfo& ci = callees[symbols.lookup(def.name)];
+    if (ci.ext) {
+      set_error(&r.error, "function '", def.name, "' conflicts with extern function");
       r.errors.push_back(r.error);
       return r;
     }
-    if (ctx.user_fn_by_name.count(def.name)) {
-      r.error.message = "duplicate function definition '" + def.name + "'";
+    if (ci.user) {
+      set_error(&r.error, "duplicate function definition '", def.name, "'");
       r.errors.push_back(r.error);
       return r;
     }
-    ctx.user_fn_by_name[def.name] = &def;
+    ci.user = &def;
+    ci.sig.result = def.return_type;
+    ci.sig.params.reserve(def.params.size());
+    for (const auto& pr : def.params)
+      ci.sig.params.push_back(pr.second);
   }
-  for (FnDef& def : program->user_fns) {
-    if (!check_fn_def(ctx, def)) {
-      r.errors.push_back(r.error);
-      r.error = {};
+  ctx.symbols = &symbols;
+  ctx.callees = &callees;
+  /* Function bodies are independent once the name maps are built; check them
+   * in parallel on large programs. Each function gets its own error slot so
+   * reporting stays in source order regardless of scheduling. */
+  const size_t fn_count = program->user_fns.size();
+  std::vector<SemaError> fn_errors(fn_count);
+  std::vector<char> fn_failed(fn_count, 0);
+  const unsigned hw = std::thread::hardware_concurrency();
+  const size_t num_workers = std::min<size_t>(hw ? hw : 1, fn_count);
+  constexpr size_t kParallelSemaThreshold = 16;  // thread spin-up beats the win below this
+  if (fn_count >= kParallelSemaThreshold && num_workers > 1) {
+    /* Workers claim small batches rather than single functions so the shared
+     * counter is touched once per few bodies; typical functions are cheap
+     * enough that per-function fetch_add contention shows up. */
+    constexpr size_t kBatch = 4;
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    workers.reserve(num_workers);
+    for (size_t w = 0; w < num_workers; ++w) {
+      workers.emplace_back([&] {
+        for (size_t base = next.fetch_add(kBatch); base < fn_count; base = next.fetch_add(kBatch)) {
+          const size_t end = std::min(base + kBatch, fn_count);
+          for (size_t i = base; i < end; ++i) {
+            if (!check_fn_def(ctx, program->user_fns[i], &fn_errors[i]))
+              fn_failed[i] = 1;
+          }
+        }
+      });
+    }
+    for (std::thread& w : workers) w.join();
+  } else {
+    for (size_t i = 0; i < fn_count; ++i) {
+      if (!check_fn_def(ctx, program->user_fns[i], &fn_errors[i]))
+        fn_failed[i] = 1;
     }
   }
-  ctx.var_scope_stack.push_back({});
-  ctx.array_element_scope_stack.push_back({});
-  ctx.fnptr_scope_stack.push_back({});
-  ctx.var_flavor_scope_stack.push_back({});
-  ctx.var_base_scope_stack.push_back({});
-  ctx.var_struct_scope_stack.push_back({});
-  ctx.array_struct_scope_stack.push_back({});
-  ctx.var_ptr_element_scope_stack.push_back({});
-  for (const TopLevelItem& item : program->top_level) {
-    if (const LetBinding* binding = std::get_if<LetBinding>(&item)) {
-      if (!check_expr(binding->init.get(), ctx)) {
-        r.errors.push_back(r.error);
-        r.error = r.errors[0];
-        return r;
-      }
-      FfiType ty = expr_type(binding->init.get(), &ctx);
-      if (ctx.var_scope_stack.back().count(binding->name)) {
-        ctx.err->message = "duplicate variable '" + binding->name + "'";
-        r.errors.push_back(r.error);
-        r.error = r.errors[0];
-        return r;
-      }
-      ctx.var_scope_stack.back()[binding->name] = ty;
-      AllocFlavor bind_flavor = expr_flavor(binding->init.get(), &ctx);
-      PtrBase bind_base = (ty == FfiType::Ptr) ? expr_base(binding->init.get(), &ctx) : PtrBase::Unknown;
-      ctx.var_flavor_scope_stack.back()[binding->name] = bind_flavor;
-      ctx.var_base_scope_stack.back()[binding->name] = bind_base;
-      if (ty == FfiType::Ptr) {
-        FnPtrSig sig;
-        if (lookup_fnptr_sig(&ctx, binding->init.get(), &sig))
-          ctx.fnptr_scope_stack.back()[binding->name] = sig;
-      }
-      FfiType elem_ty = get_array_element_type(binding->init.get(), &ctx);
-      if (elem_ty != FfiType::Void)
-        ctx.array_element_scope_stack.back()[binding->name] = elem_ty;
-      else if (ty == FfiType::Ptr && binding->init->kind == Expr::Kind::Call)
-        ctx.array_element_scope_stack.back()[binding->name] = FfiType::Ptr;
-      else if (ty == FfiType::Ptr && binding->init->kind == Expr::Kind::FieldAccess) {
-        Expr* e = binding->init.get();
-        if (!e->field_chain.empty() && !e->load_field_struct.empty() && ctx.layout_map) {
-          std::string cur = e->load_field_struct;
-          for (size_t fi = 0; fi < e->field_chain.size(); ++fi) {
-            auto it = ctx.layout_map->find(cur);
-            if (it == ctx.layout_map->end()) break;
-            bool found = false;
-            for (const auto& f : it->second.fields) {
-              if (f.first == e->field_chain[fi]) {
-                if (fi + 1 == e->field_chain.size() && f.second.type == FfiType::Ptr) {
-                  ctx.array_element_scope_stack.back()[binding->name] = FfiType::Ptr;
-                  if (!f.second.struct_name.empty() && !ctx.array_struct_scope_stack.empty())
-                    ctx.array_struct_scope_stack.back()[binding->name] = f.second.struct_name;
+  for (size_t i = 0; i < fn_count; ++i)
+    if (fn_failed[i]) r.errors.push_back(fn_errors[i]);
+  scope_reserve(ctx, 8);
+  scope_push(ctx);
+  /* One visit dispatch per item instead of a get_if chain; the Let arm sets
+   * stop to surface the hard-error cases that abort checking. */
+  bool stop = false;
+  auto check_top_level = overloaded{
+      [&](const LetBinding& binding) {
+        CheckedType init = check_and_type(binding.init.get(), ctx);
+        if (!init.ok) {
+          r.errors.push_back(r.error);
+          stop = true;
+          return;
+        }
+        FfiType ty = init.ty;
+        FfiType* bind_slot = ctx.var_scope_stack.back().try_emplace(binding.name);
+        if (!bind_slot) {
+          set_error(ctx, "duplicate variable '", binding.name, "'");
+          r.errors.push_back(r.error);
+          stop = true;
+          return;
+        }
+        *bind_slot = ty;
+        AllocFlavor bind_flavor = expr_flavor(binding.init.get(), &ctx);
+        PtrBase bind_base = (ty == FfiType::Ptr) ? expr_base(binding.init.get(), &ctx) : PtrBase::Unknown;
+        ctx.var_flavor_scope_stack.back()[binding.name] = bind_flavor;
+        ctx.var_base_scope_stack.back()[binding.name] = bind_base;
+        if (ty == FfiType::Ptr) {
+          if (const FnPtrSig* sig = lookup_fnptr_sig(&ctx, binding.init.get())) {
+            FnPtrSig copy = *sig;  // sig may point into the frame the insert grows
+            ctx.fnptr_scope_stack.back()[binding.name] = std::move(copy);
+          }
+        }
+        FfiType elem_ty = get_array_element_type(binding.init.get(), &ctx);
+        if (elem_ty != FfiType::Void)
+          ctx.array_element_scope_stack.back()[binding.name] = elem_ty;
+        else if (ty == FfiType::Ptr && binding.init->kind == Expr::Kind::Call)
+          ctx.array_element_scope_stack.back()[binding.name] = FfiType::Ptr;
+        else if (ty == FfiType::Ptr && binding.init->kind == Expr::Kind::FieldAccess) {
+          Expr* e = binding.init.get();
+          if (!e->field_chain.empty() && !e->load_field_struct.empty() && ctx.layout_map) {
+            std::string cur = e->load_field_struct;
+            for (size_t fi = 0; fi < e->field_chain.size(); ++fi) {
+              auto it = ctx.layout_map->find(cur);
+              if (it == ctx.layout_map->end()) break;
+              bool found = false;
+              if (const FieldLayout* f = it->second.find_field(e->field_chain[fi])) {
+                if (fi + 1 == e->field_chain.size() && f->type == FfiType::Ptr) {
+                  ctx.array_element_scope_stack.back()[binding.name] = FfiType::Ptr;
+                  if (!f->struct_name.empty() && !ctx.array_struct_scope_stack.empty())
+                    ctx.array_struct_scope_stack.back()[binding.name] = f->struct_name;
                 }
-                cur = f.second.struct_name.empty() ? cur : f.second.struct_name;
+                cur = f->struct_name.empty() ? cur : f->struct_name;
                 found = true;
-                break;
               }
+              if (!found) break;
             }
-            if (!found) break;
           }
         }
-      }
-      // Track ptr-to-struct for top-level bindings
-      if (ty == FfiType::Ptr) {
-        std::string sname = expr_struct_name(binding->init.get(), &ctx);
-        if (sname.empty() && binding->init->kind == Expr::Kind::Index && binding->init->left &&
-            binding->init->left->kind == Expr::Kind::VarRef)
-          sname = array_struct_lookup(&ctx, binding->init->left->var_name);
-        if (sname.empty() && binding->init && !binding->init->inferred_ptr_element.empty() &&
-            ctx.program && is_named_type_known(binding->init->inferred_ptr_element, ctx.program))
-          sname = binding->init->inferred_ptr_element;
-        if (!sname.empty()) {
-          ctx.var_struct_scope_stack.back()[binding->name] = sname;
-          if (binding->init->kind == Expr::Kind::FieldAccess && !ctx.array_struct_scope_stack.empty())
-            ctx.array_struct_scope_stack.back()[binding->name] = sname;
+        // Track ptr-to-struct for top-level bindings
+        if (ty == FfiType::Ptr) {
+          std::string sname = expr_struct_name(binding.init.get(), &ctx);
+          if (sname.empty() && binding.init->kind == Expr::Kind::Index && binding.init->left &&
+              binding.init->left->kind == Expr::Kind::VarRef)
+            sname = array_struct_lookup(&ctx, binding.init->left->var_name);
+          if (sname.empty() && binding.init && !binding.init->inferred_ptr_element.empty() &&
+              ctx.program && is_named_type_known(binding.init->inferred_ptr_element, &ctx))
+            sname = binding.init->inferred_ptr_element;
+          if (!sname.empty()) {
+            ctx.var_struct_scope_stack.back()[binding.name] = sname;
+            if (binding.init->kind == Expr::Kind::FieldAccess && !ctx.array_struct_scope_stack.empty())
+              ctx.array_struct_scope_stack.back()[binding.name] = sname;
+          }
         }
-      }
-      // Track ptr element type for top-level bindings
-      if (ty == FfiType::Ptr && !ctx.var_ptr_element_scope_stack.empty()) {
-        Expr* init = binding->init.get();
-        if (init && !init->inferred_ptr_element.empty())
-          ctx.var_ptr_element_scope_stack.back()[binding->name] = init->inferred_ptr_element;
-      }
-      // Track array element struct name
-      {
-        Expr* init = binding->init.get();
-        if (init && (init->kind == Expr::Kind::HeapArray || init->kind == Expr::Kind::StackArray) && ctx.program) {
-          const std::string& t = init->var_name;
-          if (t.size() > 5 && t.substr(0,4) == "ptr[" && t.back() == ']')
-            ctx.array_struct_scope_stack.back()[binding->name] = t.substr(4, t.size()-5);
-          else
-            for (const auto& s : ctx.program->struct_defs)
-              if (s.name == t) {
-                ctx.array_struct_scope_stack.back()[binding->name] = t;
-                break;
-              }
-        } else if (init && init->kind == Expr::Kind::Call && ty == FfiType::Ptr) {
-          std::string elem_struct = get_call_array_element_struct(init, &ctx);
-          if (!elem_struct.empty())
-            ctx.array_struct_scope_stack.back()[binding->name] = elem_struct;
+        // Track ptr element type for top-level bindings
+        if (ty == FfiType::Ptr && !ctx.var_ptr_element_scope_stack.empty()) {
+          Expr* init = binding.init.get();
+          if (init && !init->inferred_ptr_element.empty())
+            ctx.var_ptr_element_scope_stack.back()[binding.name] = init->inferred_ptr_element;
+        }
+        // Track array element struct name
+        {
+          Expr* init = binding.init.get();
+          if (init && (init->kind == Expr::Kind::HeapArray || init->kind == Expr::Kind::StackArray) && ctx.program) {
+            const std::string& t = init->var_name;
+            if (t.size() > 5 && t.substr(0,4) == "ptr[" && t.back() == ']')
+              ctx.array_struct_scope_stack.back()[binding.name] = t.substr(4, t.size()-5);
+            else if (ctx.struct_names && ctx.struct_names->contains(t))
+              ctx.array_struct_scope_stack.back()[binding.name] = t;
+          } else if (init && init->kind == Expr::Kind::Call && ty == FfiType::Ptr) {
+            std::string elem_struct = get_call_array_element_struct(init, &ctx);
+            if (!elem_struct.empty())
+              ctx.array_struct_scope_stack.back()[binding.name] = elem_struct;
+          }
         }
-      }
-    } else if (const ExprPtr* expr = std::get_if<ExprPtr>(&item)) {
-      if (!check_expr(expr->get(), ctx)) {
-        r.errors.push_back(r.error);
-        r.error = {};
-      }
-    } else {
-      const StmtPtr& stmt = std::get<StmtPtr>(item);
-      if (!check_stmt(ctx, nullptr, stmt.get())) {
-        r.errors.push_back(r.error);
-        r.error = {};
-      }
+      },
+      [&](const ExprPtr& expr) {
+        if (!check_expr(expr.get(), ctx)) {
+          r.errors.push_back(r.error);
+          r.error = {};
+        }
+      },
+      [&](const StmtPtr& stmt) {
+        if (!check_stmt(ctx, nullptr, stmt.get())) {
+          r.errors.push_back(r.error);
+          r.error = {};
+        }
+      },
+  };
+  for (const TopLevelItem& item : program->top_level) {
+    std::visit(check_top_level, item);
+    if (stop) {
+      r.error = r.errors[0];
+      return r;
     }
   }
   r.ok = r.errors.empty();
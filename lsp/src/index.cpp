@@ -1,6 +1,7 @@
 #include "index.hpp"
 
 #include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace fusion;
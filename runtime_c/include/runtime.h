@@ -1,6 +1,7 @@
 #ifndef FUSION_RUNTIME_H
 #define FUSION_RUNTIME_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -13,6 +14,13 @@ void rt_shutdown(void);
 
 void rt_print_cstring(const char *s, int64_t stream);
 
+/* Print capture hook: when set, rt_print_cstring hands the string (and the
+ * target stream id) to the sink instead of writing to stdio. Lets embedders
+ * and tests capture program output without redirecting process-wide file
+ * descriptors. Pass NULL to restore normal printing. */
+typedef void (*rt_print_sink_t)(const char *s, int64_t stream);
+void rt_set_print_sink(rt_print_sink_t sink);
+
 /* Read one line from stdin. Returns NUL-terminated buffer (Fusion-owned; invalid after next read_line). NULL on EOF/error. */
 const char *rt_read_line(void);
 
@@ -70,6 +78,8 @@ void *rt_open(const char *path, const char *mode);
 void rt_close(void *handle);
 const char *rt_read_line_file(void *handle);
 void rt_write_file_ptr(void *handle, const char *s);
+/* As rt_write_file_ptr plus a trailing newline, under one stream lock. NULL s writes just the newline. */
+void rt_writeln_file_ptr(void *handle, const char *s);
 /* Raw byte I/O. buf = buffer, count = number of bytes. Return bytes written/read, or -1 on error. */
 int64_t rt_write_bytes(void *handle, const void *buf, int64_t count);
 int64_t rt_read_bytes(void *handle, void *buf, int64_t count);
@@ -83,6 +93,9 @@ const char *rt_http_request(const char *method, const char *url, const char *bod
 int64_t rt_http_status(void);
 
 /* Print message to stderr and abort. Used when dlopen/dlsym/ffi_call fails. */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noreturn, cold))
+#endif
 void rt_panic(const char *msg);
 
 /* Dynamic loading (dlopen/dlsym). Handles are opaque pointers from dlopen/dlsym. */
@@ -122,6 +135,13 @@ rt_ffi_sig_t *rt_ffi_sig_create(rt_ffi_type_kind_t return_kind, unsigned nargs,
 /* Call foreign function. Returns 0 on success, non-zero on failure. On failure, rt_ffi_error_last() describes. */
 int rt_ffi_call(rt_ffi_sig_t *sig, void *fnptr, const void *args_buf, void *ret_buf);
 
+/* Call the same foreign function n times over rows of argument slots.
+ * args_buf holds n rows laid out rt_ffi_call-style, args_stride bytes apart; results are written
+ * ret_stride bytes apart into ret_buf (unused for void returns). Validates once for the whole
+ * batch. Returns 0 on success, non-zero on failure (rt_ffi_error_last() describes). */
+int rt_ffi_call_many(rt_ffi_sig_t *sig, void *fnptr, const void *args_buf, size_t args_stride,
+                     size_t n, void *ret_buf, size_t ret_stride);
+
 /* Last FFI error string. Lifetime: until next FFI call or sig create. Not thread-safe in v1. */
 const char *rt_ffi_error_last(void);
 
@@ -6,7 +6,7 @@
 #define RT_DL_ERRBUF_SIZE 512
 static char rt_dl_error_buf[RT_DL_ERRBUF_SIZE];
 
-static void capture_dlerror(const char *context) {
+__attribute__((cold, noinline)) static void capture_dlerror(const char *context) {
   const char *e = dlerror();
   if (e) {
     size_t n = strlen(e);
@@ -3,16 +3,21 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define RT_FFI_ERRBUF_SIZE 256
 #define RT_FFI_MAX_ARGS    32
 #define RT_FFI_SLOT_SIZE   8
-#define RT_FFI_CACHE_MAX  64
+#define RT_FFI_SIG_CHUNK  64
 
-static char rt_ffi_error_buf[RT_FFI_ERRBUF_SIZE];
+/* Per-thread and cache-line aligned: concurrent callers get their own error
+ * slot instead of racing on one array or ping-ponging a shared line. */
+static _Thread_local _Alignas(64) char rt_ffi_error_buf[RT_FFI_ERRBUF_SIZE];
 
-static void set_ffi_error(const char *msg) {
+/* Cold + noinline keeps error formatting out of line so the hot create/call
+ * paths stay short for the instruction cache. */
+__attribute__((cold, noinline)) static void set_ffi_error(const char *msg) {
   size_t n = strlen(msg);
   if (n >= RT_FFI_ERRBUF_SIZE)
     n = RT_FFI_ERRBUF_SIZE - 1;
@@ -20,30 +25,145 @@ static void set_ffi_error(const char *msg) {
   rt_ffi_error_buf[n] = '\0';
 }
 
+/* kind -> libffi type, indexed by the dense RT_FFI_VOID..RT_FFI_PTR range. */
+static ffi_type *const kind_ffi_table[RT_FFI_PTR + 1] = {
+  &ffi_type_void,    /* RT_FFI_VOID */
+  &ffi_type_sint32,  /* RT_FFI_I32 */
+  &ffi_type_sint64,  /* RT_FFI_I64 */
+  &ffi_type_float,   /* RT_FFI_F32 */
+  &ffi_type_double,  /* RT_FFI_F64 */
+  &ffi_type_pointer, /* RT_FFI_PTR */
+};
+
 static ffi_type *kind_to_ffi_type(rt_ffi_type_kind_t kind) {
-  switch (kind) {
-    case RT_FFI_VOID:    return &ffi_type_void;
-    case RT_FFI_I32:     return &ffi_type_sint32;
-    case RT_FFI_I64:     return &ffi_type_sint64;
-    case RT_FFI_F32:     return &ffi_type_float;
-    case RT_FFI_F64:     return &ffi_type_double;
-    case RT_FFI_PTR:     return &ffi_type_pointer;
-    default:             return NULL;
-  }
+  return (unsigned)kind <= RT_FFI_PTR ? kind_ffi_table[kind] : NULL;
 }
 
 static int kind_valid(rt_ffi_type_kind_t kind) {
-  return kind >= RT_FFI_VOID && kind <= RT_FFI_PTR;
+  /* One unsigned compare; enum values start at RT_FFI_VOID == 0. */
+  return (unsigned)kind <= RT_FFI_PTR;
 }
 
+/* Direct trampoline for a hot signature shape: reads the 8-byte argument
+ * slots and calls through a correctly typed C function pointer, skipping
+ * libffi's generic cif walk. NULL means "use ffi_call". */
+typedef void (*rt_ffi_dispatch_fn)(void *fnptr, const void *args_buf, void *ret_buf);
+
 struct rt_ffi_sig {
   ffi_cif cif;
+  rt_ffi_dispatch_fn dispatch; /* fast path for 0/1/2-arg scalar shapes */
+  uint32_t hash; /* sig_hash of (return_kind, nargs, arg_kinds); set at insert */
   rt_ffi_type_kind_t return_kind;
   unsigned nargs;
   rt_ffi_type_kind_t arg_kinds[RT_FFI_MAX_ARGS];
   ffi_type *arg_types[RT_FFI_MAX_ARGS];
 };
 
+/* Trampolines for every combination of return kind in {void,i32,i64,f64,ptr}
+ * and 0..2 arguments in {i64,ptr,f64} — the shapes real programs hit through
+ * get_func_ptr/call. Generated by macro expansion; anything else (f32, i32
+ * args, longer arg lists) falls back to the generic ffi_call path. */
+#define RT_ARG_i64(a, i) (*(const int64_t *)((const char *)(a) + (i) * RT_FFI_SLOT_SIZE))
+#define RT_ARG_ptr(a, i) (*(void *const *)((const char *)(a) + (i) * RT_FFI_SLOT_SIZE))
+#define RT_ARG_f64(a, i) (*(const double *)((const char *)(a) + (i) * RT_FFI_SLOT_SIZE))
+
+/* Result stores; i32 widens into the 8-byte slot the way libffi's ffi_arg does. */
+#define RT_RET_void(call) (void)(call)
+#define RT_RET_i32(call)  (*(int64_t *)r = (int64_t)(call))
+#define RT_RET_i64(call)  (*(int64_t *)r = (call))
+#define RT_RET_f64(call)  (*(double *)r = (call))
+#define RT_RET_ptr(call)  (*(void **)r = (call))
+
+#define RT_CT_void void
+#define RT_CT_i32  int32_t
+#define RT_CT_i64  int64_t
+#define RT_CT_f64  double
+#define RT_CT_ptr  void *
+
+#define RT_DEF0(rk)                                                   \
+  static void call_##rk##_(void *fn, const void *a, void *r) {        \
+    (void)a; (void)r;                                                 \
+    RT_RET_##rk(((RT_CT_##rk (*)(void))fn)());                        \
+  }
+#define RT_DEF1(rk, a0)                                               \
+  static void call_##rk##_##a0(void *fn, const void *a, void *r) {    \
+    (void)r;                                                          \
+    RT_RET_##rk(((RT_CT_##rk (*)(RT_CT_##a0))fn)(RT_ARG_##a0(a, 0))); \
+  }
+#define RT_DEF2(rk, a0, a1)                                           \
+  static void call_##rk##_##a0##_##a1(void *fn, const void *a, void *r) { \
+    (void)r;                                                          \
+    RT_RET_##rk(((RT_CT_##rk (*)(RT_CT_##a0, RT_CT_##a1))fn)(         \
+        RT_ARG_##a0(a, 0), RT_ARG_##a1(a, 1)));                       \
+  }
+
+#define RT_DEF1_ALL(rk) RT_DEF1(rk, i64) RT_DEF1(rk, ptr) RT_DEF1(rk, f64)
+#define RT_DEF2_A0(rk, a0) RT_DEF2(rk, a0, i64) RT_DEF2(rk, a0, ptr) RT_DEF2(rk, a0, f64)
+#define RT_DEF2_ALL(rk) RT_DEF2_A0(rk, i64) RT_DEF2_A0(rk, ptr) RT_DEF2_A0(rk, f64)
+#define RT_DEF_SHAPES(rk) RT_DEF0(rk) RT_DEF1_ALL(rk) RT_DEF2_ALL(rk)
+
+RT_DEF_SHAPES(void)
+RT_DEF_SHAPES(i32)
+RT_DEF_SHAPES(i64)
+RT_DEF_SHAPES(f64)
+RT_DEF_SHAPES(ptr)
+
+/* Dispatch tables indexed by [ret][arg0][arg1] class; rows mirror the macro
+ * expansion order above. */
+#define RT_ROW1(rk) { call_##rk##_i64, call_##rk##_ptr, call_##rk##_f64 }
+#define RT_ROW2(rk, a0) \
+  { call_##rk##_##a0##_i64, call_##rk##_##a0##_ptr, call_##rk##_##a0##_f64 }
+#define RT_BLOCK2(rk) { RT_ROW2(rk, i64), RT_ROW2(rk, ptr), RT_ROW2(rk, f64) }
+
+static const rt_ffi_dispatch_fn dispatch0[5] = {
+  call_void_, call_i32_, call_i64_, call_f64_, call_ptr_,
+};
+static const rt_ffi_dispatch_fn dispatch1[5][3] = {
+  RT_ROW1(void), RT_ROW1(i32), RT_ROW1(i64), RT_ROW1(f64), RT_ROW1(ptr),
+};
+static const rt_ffi_dispatch_fn dispatch2[5][3][3] = {
+  RT_BLOCK2(void), RT_BLOCK2(i32), RT_BLOCK2(i64), RT_BLOCK2(f64), RT_BLOCK2(ptr),
+};
+
+static int ret_class(rt_ffi_type_kind_t kind) {
+  switch (kind) {
+    case RT_FFI_VOID: return 0;
+    case RT_FFI_I32:  return 1;
+    case RT_FFI_I64:  return 2;
+    case RT_FFI_F64:  return 3;
+    case RT_FFI_PTR:  return 4;
+    default:          return -1;
+  }
+}
+
+static int arg_class(rt_ffi_type_kind_t kind) {
+  switch (kind) {
+    case RT_FFI_I64: return 0;
+    case RT_FFI_PTR: return 1;
+    case RT_FFI_F64: return 2;
+    default:         return -1;
+  }
+}
+
+static rt_ffi_dispatch_fn pick_dispatch(rt_ffi_type_kind_t return_kind,
+                                        unsigned nargs,
+                                        const rt_ffi_type_kind_t *arg_kinds) {
+  int rc = ret_class(return_kind);
+  if (rc < 0 || nargs > 2)
+    return NULL;
+  if (nargs == 0)
+    return dispatch0[rc];
+  int a0 = arg_class(arg_kinds[0]);
+  if (a0 < 0)
+    return NULL;
+  if (nargs == 1)
+    return dispatch1[rc][a0];
+  int a1 = arg_class(arg_kinds[1]);
+  if (a1 < 0)
+    return NULL;
+  return dispatch2[rc][a0][a1];
+}
+
 static int sig_matches(const struct rt_ffi_sig *s, rt_ffi_type_kind_t return_kind,
                        unsigned nargs, const rt_ffi_type_kind_t *arg_kinds) {
   if (s->return_kind != return_kind || s->nargs != nargs)
@@ -54,8 +174,81 @@ static int sig_matches(const struct rt_ffi_sig *s, rt_ffi_type_kind_t return_kin
   return 1;
 }
 
-static struct rt_ffi_sig *sig_cache[RT_FFI_CACHE_MAX];
-static unsigned sig_cache_count;
+/* Signature storage grows on demand in chunks of RT_FFI_SIG_CHUNK slots.
+ * Chunks are never reallocated or freed, so signature pointers handed out
+ * earlier stay stable — libffi requires the prepared ffi_cif not to move. */
+static struct rt_ffi_sig **sig_chunks;
+static unsigned sig_chunk_count;
+static unsigned sig_count;
+
+/* Open-addressed index over the storage, probed linearly from hash & mask.
+ * Each bucket carries the hash next to the pointer, so a probe rejects
+ * non-matching candidates from the dense bucket array alone without pulling
+ * in the cif-bearing signature struct; the struct is only touched for the
+ * final sig_matches verification. Rehashed at doubling size whenever load
+ * would pass one half, so a free bucket always exists and probes stay short. */
+struct sig_bucket {
+  struct rt_ffi_sig *s;
+  uint32_t hash;
+};
+static struct sig_bucket *sig_buckets;
+static unsigned sig_bucket_cap;
+
+static struct rt_ffi_sig *sig_slot(unsigned index) {
+  return &sig_chunks[index / RT_FFI_SIG_CHUNK][index % RT_FFI_SIG_CHUNK];
+}
+
+/* Ensure the bucket table can index sig_count + 1 entries at <= 1/2 load.
+ * Returns 0 on allocation failure. */
+static int sig_buckets_reserve(void) {
+  if (sig_buckets != NULL && (sig_count + 1) * 2 <= sig_bucket_cap)
+    return 1;
+  unsigned new_cap = sig_bucket_cap ? sig_bucket_cap * 2 : RT_FFI_SIG_CHUNK * 2;
+  struct sig_bucket *new_buckets =
+      (struct sig_bucket *)calloc(new_cap, sizeof(*new_buckets));
+  if (new_buckets == NULL)
+    return 0;
+  for (unsigned i = 0; i < sig_count; i++) {
+    struct rt_ffi_sig *s = sig_slot(i);
+    unsigned b = s->hash & (new_cap - 1);
+    while (new_buckets[b].s != NULL)
+      b = (b + 1) & (new_cap - 1);
+    new_buckets[b].s = s;
+    new_buckets[b].hash = s->hash;
+  }
+  free(sig_buckets);
+  sig_buckets = new_buckets;
+  sig_bucket_cap = new_cap;
+  return 1;
+}
+
+/* Ensure a storage slot exists for signature index sig_count. */
+static int sig_chunks_reserve(void) {
+  if (sig_count < sig_chunk_count * RT_FFI_SIG_CHUNK)
+    return 1;
+  struct rt_ffi_sig **new_chunks = (struct rt_ffi_sig **)realloc(
+      sig_chunks, (sig_chunk_count + 1) * sizeof(*sig_chunks));
+  if (new_chunks == NULL)
+    return 0;
+  sig_chunks = new_chunks;
+  struct rt_ffi_sig *chunk =
+      (struct rt_ffi_sig *)calloc(RT_FFI_SIG_CHUNK, sizeof(*chunk));
+  if (chunk == NULL)
+    return 0;
+  sig_chunks[sig_chunk_count++] = chunk;
+  return 1;
+}
+
+/* FNV-1a over the bytes that define a signature. */
+static uint32_t sig_hash(rt_ffi_type_kind_t return_kind, unsigned nargs,
+                         const rt_ffi_type_kind_t *arg_kinds) {
+  uint32_t h = 2166136261u;
+  h = (h ^ (uint32_t)return_kind) * 16777619u;
+  h = (h ^ nargs) * 16777619u;
+  for (unsigned i = 0; i < nargs; i++)
+    h = (h ^ (uint32_t)arg_kinds[i]) * 16777619u;
+  return h;
+}
 
 rt_ffi_sig_t *rt_ffi_sig_create(rt_ffi_type_kind_t return_kind, unsigned nargs,
                                 const rt_ffi_type_kind_t *arg_kinds) {
@@ -80,18 +273,25 @@ rt_ffi_sig_t *rt_ffi_sig_create(rt_ffi_type_kind_t return_kind, unsigned nargs,
     }
   }
 
-  for (unsigned i = 0; i < sig_cache_count; i++) {
-    if (sig_matches(sig_cache[i], return_kind, nargs, arg_kinds))
-      return (rt_ffi_sig_t *)sig_cache[i];
+  uint32_t h = sig_hash(return_kind, nargs, arg_kinds);
+  if (sig_buckets != NULL) {
+    unsigned b = h & (sig_bucket_cap - 1);
+    while (sig_buckets[b].s != NULL) {
+      if (sig_buckets[b].hash == h &&
+          sig_matches(sig_buckets[b].s, return_kind, nargs, arg_kinds))
+        return (rt_ffi_sig_t *)sig_buckets[b].s;
+      b = (b + 1) & (sig_bucket_cap - 1);
+    }
   }
 
-  if (sig_cache_count >= RT_FFI_CACHE_MAX) {
-    set_ffi_error("rt_ffi_sig_create: signature cache full");
+  if (!sig_buckets_reserve() || !sig_chunks_reserve()) {
+    set_ffi_error("rt_ffi_sig_create: out of memory");
     return NULL;
   }
 
-  static struct rt_ffi_sig sig_storage[RT_FFI_CACHE_MAX];
-  struct rt_ffi_sig *s = &sig_storage[sig_cache_count];
+  struct rt_ffi_sig *s = sig_slot(sig_count);
+  s->hash = h;
+  s->dispatch = pick_dispatch(return_kind, nargs, arg_kinds);
   s->return_kind = return_kind;
   s->nargs = nargs;
   for (unsigned i = 0; i < nargs; i++) {
@@ -107,7 +307,13 @@ rt_ffi_sig_t *rt_ffi_sig_create(rt_ffi_type_kind_t return_kind, unsigned nargs,
     return NULL;
   }
 
-  sig_cache[sig_cache_count++] = s;
+  /* Re-probe for the insert slot: the reserve above may have rehashed. */
+  unsigned b = h & (sig_bucket_cap - 1);
+  while (sig_buckets[b].s != NULL)
+    b = (b + 1) & (sig_bucket_cap - 1);
+  sig_buckets[b].s = s;
+  sig_buckets[b].hash = h;
+  sig_count++;
   return (rt_ffi_sig_t *)s;
 }
 
@@ -138,6 +344,11 @@ int rt_ffi_call(rt_ffi_sig_t *sig, void *fnptr, const void *args_buf, void *ret_
     return -1;
   }
 
+  if (s->dispatch != NULL) {
+    s->dispatch(fnptr, args_buf, rvalue);
+    return 0;
+  }
+
   void *avalues[RT_FFI_MAX_ARGS];
   const char *p = (const char *)args_buf;
   for (unsigned i = 0; i < nargs; i++)
@@ -147,6 +358,62 @@ int rt_ffi_call(rt_ffi_sig_t *sig, void *fnptr, const void *args_buf, void *ret_
   return 0;
 }
 
+int rt_ffi_call_many(rt_ffi_sig_t *sig, void *fnptr, const void *args_buf,
+                     size_t args_stride, size_t n, void *ret_buf,
+                     size_t ret_stride) {
+  rt_ffi_error_buf[0] = '\0';
+
+  if (sig == NULL) {
+    set_ffi_error("rt_ffi_call_many: null signature");
+    return -1;
+  }
+  if (fnptr == NULL) {
+    set_ffi_error("rt_ffi_call_many: null function pointer");
+    return -1;
+  }
+
+  struct rt_ffi_sig *s = (struct rt_ffi_sig *)sig;
+  unsigned nargs = s->nargs;
+
+  if (n == 0)
+    return 0;
+  if (nargs > 0 && args_buf == NULL) {
+    set_ffi_error("rt_ffi_call_many: null args_buf");
+    return -1;
+  }
+  if (s->return_kind != RT_FFI_VOID && ret_buf == NULL) {
+    set_ffi_error("rt_ffi_call_many: null ret_buf for non-void return");
+    return -1;
+  }
+
+  /* Validation above is paid once for the whole batch; the loop below only
+   * rebases the avalues slots per row and re-enters libffi. */
+  uint8_t ret_storage[RT_FFI_SLOT_SIZE];
+  void *avalues[RT_FFI_MAX_ARGS];
+  const char *args_row = (const char *)args_buf;
+  char *ret_row = (char *)ret_buf;
+  int is_void = (s->return_kind == RT_FFI_VOID);
+  if (s->dispatch != NULL) {
+    for (size_t row = 0; row < n; row++) {
+      s->dispatch(fnptr, args_row, is_void ? ret_storage : (void *)ret_row);
+      args_row += args_stride;
+      if (!is_void)
+        ret_row += ret_stride;
+    }
+    return 0;
+  }
+  for (size_t row = 0; row < n; row++) {
+    for (unsigned i = 0; i < nargs; i++)
+      avalues[i] = (void *)(args_row + i * RT_FFI_SLOT_SIZE);
+    ffi_call(&s->cif, FFI_FN(fnptr), is_void ? ret_storage : (void *)ret_row,
+             avalues);
+    args_row += args_stride;
+    if (!is_void)
+      ret_row += ret_stride;
+  }
+  return 0;
+}
+
 const char *rt_ffi_error_last(void) {
   return rt_ffi_error_buf[0] ? rt_ffi_error_buf : NULL;
 }
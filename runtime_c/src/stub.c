@@ -1,3 +1,4 @@
+#define _GNU_SOURCE /* fputs_unlocked and friends */
 #include "runtime.h"
 #include <stdint.h>
 #include <stdio.h>
@@ -16,9 +17,33 @@
 #define PRINT_BUF_SIZE 256
 #define LINE_BUF_SIZE 4096
 
-static char line_buf[LINE_BUF_SIZE];
-static char to_str_buf[PRINT_BUF_SIZE];
-static char file_line_buf[LINE_BUF_SIZE];
+/* stdio without the per-call stream lock: each runtime entry point takes the
+ * lock once with flockfile and uses the _unlocked variants inside, instead of
+ * paying one lock round-trip per stdio call. Plain stdio elsewhere. */
+#ifdef __GLIBC__
+#define rt_lock_file(f)    flockfile(f)
+#define rt_unlock_file(f)  funlockfile(f)
+#define rt_fread_nolock    fread_unlocked
+#define rt_fwrite_nolock   fwrite_unlocked
+#define rt_fputs_nolock    fputs_unlocked
+#else
+#define rt_lock_file(f)    ((void)0)
+#define rt_unlock_file(f)  ((void)0)
+#define rt_fread_nolock    fread
+#define rt_fwrite_nolock   fwrite
+#define rt_fputs_nolock    fputs
+#endif
+
+/* Per-thread and cache-line aligned: two threads formatting or reading lines
+ * concurrently each get their own buffer instead of tearing a shared one.
+ * The returned-pointer lifetime rules are unchanged — valid until the next
+ * call on the same thread. */
+static _Thread_local _Alignas(64) char to_str_buf[PRINT_BUF_SIZE];
+#ifdef _WIN32
+/* Fixed-size line buffers for the fgets fallback; POSIX reads via getline. */
+static _Thread_local _Alignas(64) char line_buf[LINE_BUF_SIZE];
+static _Thread_local _Alignas(64) char file_line_buf[LINE_BUF_SIZE];
+#endif
 
 /* Simple string arena for rt_str_dup / rt_str_concat.
  * Not thread-safe (matches rest of stub.c). Strings are reclaimed by rt_shutdown().
@@ -56,30 +81,104 @@ void rt_shutdown(void) {
   rt_str_head = NULL;
 }
 
+static rt_print_sink_t rt_print_sink;
+
+void rt_set_print_sink(rt_print_sink_t sink) {
+  rt_print_sink = sink;
+}
+
 void rt_print_cstring(const char *s, int64_t stream) {
   if (!s) {
-    fprintf(stream_for(stream), "(null)");
-    return;
+    s = "(null)";
+  } else if ((uintptr_t)s < 4096) {
+    /* Avoid strlen on obviously invalid pointers (e.g. small integers passed as ptr). */
+    s = "(invalid)";
   }
-  /* Avoid strlen on obviously invalid pointers (e.g. small integers passed as ptr). */
-  if ((uintptr_t)s < 4096) {
-    fprintf(stream_for(stream), "(invalid)");
+  if (rt_print_sink) {
+    rt_print_sink(s, stream);
     return;
   }
-  fprintf(stream_for(stream), "%s", s);
+  FILE *f = stream_for(stream);
+  rt_lock_file(f);
+  rt_fputs_nolock(s, f);
+  rt_unlock_file(f);
 }
 
+/* Read one line from f into a per-thread growable buffer via getline: the
+ * length comes back from the call (no strlen re-scan of the buffer) and lines
+ * are no longer capped at LINE_BUF_SIZE. The buffer lives for the thread;
+ * callers already treat the result as invalid after the next read. Trailing
+ * \n and \r\n are stripped. */
+#ifndef _WIN32
+static const char *read_line_from(FILE *f, char **buf, size_t *cap) {
+  ssize_t len = getline(buf, cap, f);
+  if (len < 0)
+    return NULL;
+  char *s = *buf;
+  if (len > 0 && s[len - 1] == '\n')
+    s[--len] = '\0';
+  if (len > 0 && s[len - 1] == '\r')
+    s[--len] = '\0';
+  return s;
+}
+#endif
+
 const char *rt_read_line(void) {
+#ifndef _WIN32
+  static _Thread_local char *stdin_line_buf;
+  static _Thread_local size_t stdin_line_cap;
+  return read_line_from(stdin, &stdin_line_buf, &stdin_line_cap);
+#else
   if (!fgets(line_buf, (int)sizeof(line_buf), stdin))
     return NULL;
   size_t len = strlen(line_buf);
   if (len > 0 && line_buf[len - 1] == '\n')
     line_buf[len - 1] = '\0';
   return line_buf;
+#endif
+}
+
+/* Pairs "00".."99" for two-digits-at-a-time integer formatting. */
+static const char dec_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Unsigned decimal into out (no terminator); returns digit count. Peels two
+ * digits per divide instead of one, then reverses — far cheaper than the
+ * locale-aware printf machinery for the common short numbers. */
+static size_t u64_to_dec(uint64_t v, char *out) {
+  char tmp[20];
+  size_t n = 0;
+  while (v >= 100) {
+    unsigned pair = (unsigned)(v % 100) * 2;
+    v /= 100;
+    tmp[n++] = dec_pairs[pair + 1];
+    tmp[n++] = dec_pairs[pair];
+  }
+  if (v >= 10) {
+    unsigned pair = (unsigned)v * 2;
+    tmp[n++] = dec_pairs[pair + 1];
+    tmp[n++] = dec_pairs[pair];
+  } else {
+    tmp[n++] = (char)('0' + (unsigned)v);
+  }
+  for (size_t i = 0; i < n; i++)
+    out[i] = tmp[n - 1 - i];
+  return n;
 }
 
 const char *rt_to_str_i64(int64_t value) {
-  (void)snprintf(to_str_buf, sizeof(to_str_buf), "%lld", (long long)value);
+  char *p = to_str_buf;
+  uint64_t u = (uint64_t)value;
+  if (value < 0) {
+    *p++ = '-';
+    u = 0u - u; /* two's-complement negate handles INT64_MIN */
+  }
+  size_t n = u64_to_dec(u, p);
+  p[n] = '\0';
   return to_str_buf;
 }
 
@@ -216,7 +315,17 @@ int64_t rt_str_eq(const char *a, const char *b) {
 
 void *rt_open(const char *path, const char *mode) {
   if (!path || !mode) return NULL;
-  return (void *)fopen(path, mode);
+  FILE *f = fopen(path, mode);
+  if (!f) return NULL;
+  /* Fusion file loops are overwhelmingly sequential scans or appends; a
+   * 64 KiB stdio buffer cuts read/write syscalls 16x over the 4 KiB default,
+   * and the readahead hint lets the kernel stream large files. */
+  (void)setvbuf(f, NULL, _IOFBF, 64 * 1024);
+#if defined(__linux__) || _POSIX_C_SOURCE >= 200112L
+  if (mode[0] == 'r')
+    (void)posix_fadvise(fileno(f), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  return (void *)f;
 }
 
 void rt_close(void *handle) {
@@ -226,25 +335,48 @@ void rt_close(void *handle) {
 
 const char *rt_read_line_file(void *handle) {
   if (!handle) return NULL;
+#ifndef _WIN32
+  static _Thread_local char *file_getline_buf;
+  static _Thread_local size_t file_getline_cap;
+  return read_line_from((FILE *)handle, &file_getline_buf, &file_getline_cap);
+#else
   if (!fgets(file_line_buf, (int)sizeof(file_line_buf), (FILE *)handle))
     return NULL;
   size_t len = strlen(file_line_buf);
   if (len > 0 && file_line_buf[len - 1] == '\n')
     file_line_buf[len - 1] = '\0';
   return file_line_buf;
+#endif
 }
 
 void rt_write_file_ptr(void *handle, const char *s) {
   if (!handle) return;
+  if (s) {
+    FILE *f = (FILE *)handle;
+    rt_lock_file(f);
+    rt_fputs_nolock(s, f);
+    rt_unlock_file(f);
+  }
+}
+
+void rt_writeln_file_ptr(void *handle, const char *s) {
+  if (!handle) return;
+  FILE *f = (FILE *)handle;
+  rt_lock_file(f);
   if (s)
-    fputs(s, (FILE *)handle);
+    rt_fputs_nolock(s, f);
+  rt_fputs_nolock("\n", f);
+  rt_unlock_file(f);
 }
 
 int64_t rt_write_bytes(void *handle, const void *buf, int64_t count) {
   if (!handle || !buf || count < 0) return -1;
   size_t n = (size_t)count;
   if (n != (uint64_t)count) return -1; /* overflow */
-  size_t w = fwrite(buf, 1, n, (FILE *)handle);
+  FILE *f = (FILE *)handle;
+  rt_lock_file(f);
+  size_t w = rt_fwrite_nolock(buf, 1, n, f);
+  rt_unlock_file(f);
   return (int64_t)w;
 }
 
@@ -252,7 +384,10 @@ int64_t rt_read_bytes(void *handle, void *buf, int64_t count) {
   if (!handle || !buf || count < 0) return -1;
   size_t n = (size_t)count;
   if (n != (uint64_t)count) return -1;
-  size_t r = fread(buf, 1, n, (FILE *)handle);
+  FILE *f = (FILE *)handle;
+  rt_lock_file(f);
+  size_t r = rt_fread_nolock(buf, 1, n, f);
+  rt_unlock_file(f);
   return (int64_t)r;
 }
 
@@ -263,14 +398,26 @@ int64_t rt_eof_file(void *handle) {
 
 int64_t rt_line_count_file(void *handle) {
   if (!handle) return 0;
+  /* Read in large chunks and let memchr do the byte scan (vectorized in
+   * libc) instead of one locked fgetc call per byte. */
+  char buf[65536];
   int64_t count = 0;
-  int c;
-  while ((c = fgetc((FILE *)handle)) != EOF)
-    if (c == '\n') count++;
+  size_t r;
+  FILE *f = (FILE *)handle;
+  rt_lock_file(f);
+  while ((r = rt_fread_nolock(buf, 1, sizeof(buf), f)) > 0) {
+    const char *p = buf;
+    const char *end = buf + r;
+    while ((p = (const char *)memchr(p, '\n', (size_t)(end - p))) != NULL) {
+      count++;
+      p++;
+    }
+  }
+  rt_unlock_file(f);
   return count;
 }
 
-static char chr_buf[2] = {0, 0};
+static _Thread_local char chr_buf[2] = {0, 0};
 
 const char *rt_chr(int64_t code) {
   chr_buf[0] = (char)(unsigned char)code;
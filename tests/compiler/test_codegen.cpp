@@ -11,6 +11,14 @@
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/Support/raw_ostream.h>
 
+/* One context for the whole test binary: LLVMContext construction sets up
+ * sizable internal allocators, and none of these cases needs isolation —
+ * every module is emitted fresh and only inspected, never executed. */
+static llvm::LLVMContext& shared_ctx() {
+  static llvm::LLVMContext ctx;
+  return ctx;
+}
+
 static std::string module_ir(llvm::Module* module) {
   std::string ir;
   llvm::raw_string_ostream os(ir);
@@ -25,8 +33,7 @@ TEST(CodegenTests, EmitsModuleWithFusionMain) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok);
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   EXPECT_NE(module->getFunction("fusion_main"), nullptr);
   EXPECT_NE(module->getFunction("rt_print_cstring"), nullptr);
@@ -39,8 +46,7 @@ TEST(CodegenTests, EmitsFreeAndFreeArray) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok);
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   EXPECT_NE(module->getFunction("free"), nullptr);
 }
@@ -51,8 +57,7 @@ TEST(CodegenTests, EmitsCompareForEqNeq) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   std::string ir = module_ir(module.get());
   EXPECT_TRUE(ir.find("icmp") != std::string::npos)
@@ -67,8 +72,7 @@ TEST(CodegenTests, EmitsStructFieldGEP) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   std::string ir = module_ir(module.get());
   EXPECT_TRUE(ir.find("getelementptr") != std::string::npos)
@@ -81,8 +85,7 @@ TEST(CodegenTests, EmitsHeapArrayMallocCall) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   EXPECT_NE(module->getFunction("malloc"), nullptr)
     << "expected malloc declaration for heap_array";
@@ -94,8 +97,7 @@ TEST(CodegenTests, EmitsStackAllocaForStackArray) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   std::string ir = module_ir(module.get());
   EXPECT_TRUE(ir.find("alloca") != std::string::npos)
@@ -109,8 +111,7 @@ TEST(CodegenTests, EmitsCastFPToSI) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   std::string ir = module_ir(module.get());
   EXPECT_TRUE(ir.find("fptosi") != std::string::npos)
@@ -124,8 +125,7 @@ TEST(CodegenTests, EmitsCastSIToFP) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   std::string ir = module_ir(module.get());
   EXPECT_TRUE(ir.find("sitofp") != std::string::npos)
@@ -138,8 +138,7 @@ TEST(CodegenTests, EmitsStringLiteralGlobal) {
   ASSERT_TRUE(parse_result.ok());
   auto sema_result = fusion::check(parse_result.program.get());
   ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  llvm::LLVMContext ctx;
-  auto module = fusion::codegen(ctx, parse_result.program.get());
+  auto module = fusion::codegen(shared_ctx(), parse_result.program.get());
   ASSERT_NE(module, nullptr);
   std::string ir = module_ir(module.get());
   /* String literals are embedded as global constants with their content */
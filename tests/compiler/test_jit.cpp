@@ -3,6 +3,7 @@
 #include "layout.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "runtime.h"
 #include "sema.hpp"
 #include <gtest/gtest.h>
 #include <cstdio>
@@ -18,158 +19,92 @@
 #ifdef FUSION_HAVE_LLVM
 #include <llvm/IR/LLVMContext.h>
 
-TEST(JitTests, ExecutesPrintOnePlusTwo) {
-  auto tokens = fusion::lex("println(1+2)");
+/* Captures runtime print output in-process via the rt_set_print_sink hook,
+ * avoiding the freopen/dup2 dance that mutates the process-wide stdout. */
+static std::string g_print_capture;
+extern "C" void jit_print_capture(const char* s, int64_t stream) {
+  (void)stream;
+  g_print_capture += s;
+}
+
+/* Shared lex→parse→check→codegen→JIT driver for the common straight-line
+ * cases. Pipeline failures are reported here and come back as a not-ok
+ * CodegenResult, so callers only assert on the final result and the
+ * captured output. */
+static fusion::CodegenResult compile_and_run(const std::string& src) {
+  fusion::CodegenResult failed;
+  auto tokens = fusion::lex(src);
   auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
+  EXPECT_TRUE(parse_result.ok()) << "parse failed: " << parse_result.error.message;
+  if (!parse_result.ok()) return failed;
   auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
+  EXPECT_TRUE(sema_result.ok) << "sema failed: " << sema_result.error.message;
+  if (!sema_result.ok) return failed;
   auto ctx = std::make_unique<llvm::LLVMContext>();
   auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  EXPECT_NE(module, nullptr) << fusion::codegen_last_error();
+  if (!module) return failed;
+  return fusion::run_jit(std::move(module), std::move(ctx));
+}
+
+TEST(JitTests, ExecutesPrintOnePlusTwo) {
+  auto jit_result = compile_and_run("println(1+2)");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesSub) {
-  auto tokens = fusion::lex("println(5-2)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("println(5-2)");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesLetAndForOnly) {
-  auto tokens = fusion::lex("let n = 1; for (let i = 0; i < n; i = i + 1) { }");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("let n = 1; for (let i = 0; i < n; i = i + 1) { }");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesMulAndDiv) {
-  auto tokens = fusion::lex("println(3*4); println(10/2)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("println(3*4); println(10/2)");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesCos) {
-  auto tokens = fusion::lex("extern lib \"libm.so.6\"; extern fn cos(x: f64) -> f64; println(cos(0.0))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("extern lib \"libm.so.6\"; extern fn cos(x: f64) -> f64; println(cos(0.0))");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesLetPrint) {
-  auto tokens = fusion::lex("let x = 1 + 2; println(x)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("let x = 1 + 2; println(x)");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesLetCos) {
-  auto tokens = fusion::lex("extern lib \"libm.so.6\"; extern fn cos(x: f64) -> f64; let x = cos(0.0); println(x)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("extern lib \"libm.so.6\"; extern fn cos(x: f64) -> f64; let x = cos(0.0); println(x)");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, MixedFloatIntAdditionProducesF64) {
   /* let z = cos(1.0); let x = z + 2; println(x) => result must be F64 (2.540302...), not truncated to 2 */
-  const char* path = "/tmp/fusion_jit_mixed_add_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "extern lib \"libm.so.6\"; extern fn cos(x: f64) -> f64; let z = cos(1.0); let x = z + 2; println(x)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
+  rt_set_print_sink(nullptr);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 
-  FILE* cap = fopen(path, "r");
-  ASSERT_NE(cap, nullptr);
-  char buf[64];
-  ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
-  fclose(cap);
-  unlink(path);
-  double value = std::atof(buf);
+  double value = std::atof(g_print_capture.c_str());
   EXPECT_NEAR(value, 2.5403023058681398, 0.0001)
-      << "mixed f64+i64 add should yield cos(1.0)+2 ~= 2.540302, got " << buf;
+      << "mixed f64+i64 add should yield cos(1.0)+2 ~= 2.540302, got " << g_print_capture;
 }
 
 TEST(JitTests, IntegerAdditionStillProducesI64) {
   /* let a = 1; let b = 2; println(a + b) => must still print 3 (int+int unchanged) */
-  const char* path = "/tmp/fusion_jit_int_add_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let a = 1; let b = 2; println(a + b)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok);
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let a = 1; let b = 2; println(a + b)");
+  rt_set_print_sink(nullptr);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 
-  FILE* cap = fopen(path, "r");
-  ASSERT_NE(cap, nullptr);
-  char buf[32];
-  ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
-  fclose(cap);
-  unlink(path);
-  EXPECT_STREQ(buf, "3\n") << "int+int should still print 3";
+  EXPECT_EQ(g_print_capture, "3\n") << "int+int should still print 3";
 }
 
 TEST(JitTests, ExecutesOutParam) {
@@ -178,15 +113,7 @@ TEST(JitTests, ExecutesOutParam) {
   std::string src = "extern lib \"";
   src += so_path;
   src += "\"; extern fn set_int_out(out: ptr[void], v: i64) -> void; let p = heap(i64); store(p, 0); set_int_out(p, 42); println(load(p)); free(as_heap(p))";
-  auto tokens = fusion::lex(src);
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << "parse failed: " << parse_result.error.message << " at " << parse_result.error.line << ":" << parse_result.error.column << " src=" << src;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run(src);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
@@ -195,15 +122,7 @@ TEST(JitTests, ExecutesStructByPointer) {
   std::string src = "struct Point { x: f64; y: f64; }; extern lib \"";
   src += so_path;
   src += "\"; extern fn point_set(p: Point, x: f64, y: f64) -> void; extern fn point_x(p: Point) -> f64; let p = heap(Point); point_set(p, 1.0, 2.0); println(point_x(p)); free(as_heap(p))";
-  auto tokens = fusion::lex(src);
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << "parse failed: " << parse_result.error.message << " at " << parse_result.error.line << ":" << parse_result.error.column;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run(src);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
@@ -212,25 +131,15 @@ TEST(JitTests, ExecutesLoadField) {
   std::string src = "struct Point { x: f64; y: f64; }; extern lib \"";
   src += so_path;
   src += "\"; extern fn point_set(p: Point, x: f64, y: f64) -> void; let p = heap(Point); point_set(p, 3.0, 4.0); println(p.x); println(p.y); free(as_heap(p))";
-  auto tokens = fusion::lex(src);
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << "parse failed: " << parse_result.error.message << " at " << parse_result.error.line << ":" << parse_result.error.column;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run(src);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesCallThroughStructField) {
   /* structs.fusion-style: store get_func_ptr(add/mul) in Operation.func, call via op.func. */
-  const char* path = "/tmp/fusion_jit_indirect_call.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct Operation { func: ptr[void]; x: f64; y: f64; }; "
       "fn add(x: f64, y: f64) -> f64 { return x + y; } "
       "fn mul(x: f64, y: f64) -> f64 { return x * y; } "
@@ -251,38 +160,24 @@ TEST(JitTests, ExecutesCallThroughStructField) {
       "println(perform_operation(op_add)); "
       "println(perform_operation(op_mul)); "
       "free(as_heap(op_add)); free(as_heap(op_mul))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
-  ASSERT_NE(cap, nullptr);
-  char buf[64];
-  ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
-  EXPECT_TRUE(std::atof(buf) == 7.0 || std::atof(buf) == 12.0) << "first line should be 7 or 12, got " << buf;
-  ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
-  EXPECT_TRUE(std::atof(buf) == 7.0 || std::atof(buf) == 12.0) << "second line should be 7 or 12, got " << buf;
-  fclose(cap);
-  unlink(path);
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  std::istringstream lines(g_print_capture);
+  std::string line;
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_TRUE(std::atof(line.c_str()) == 7.0 || std::atof(line.c_str()) == 12.0)
+      << "first line should be 7 or 12, got " << line;
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_TRUE(std::atof(line.c_str()) == 7.0 || std::atof(line.c_str()) == 12.0)
+      << "second line should be 7 or 12, got " << line;
 }
 
 TEST(JitTests, AllocArrayHeapEscapesFunction) {
   /* value.fusion-style: array allocated in add_forward is stored in Value.prev and read in add_backward.
      Requires heap_array to be heap-allocated; with stack allocation the pointer would be dangling. */
-  const char* path = "/tmp/fusion_jit_array_escape_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct Value { data: f64; grad: f64; prev: ptr[void]; children_count: i64; backward: ptr[void]; }; "
       "fn alloc_value(data: f64, prev: ptr[void], children_count: i64, backward: ptr[void]) -> ptr[void] { "
       "  let value = heap(Value); "
@@ -324,20 +219,10 @@ TEST(JitTests, AllocArrayHeapEscapesFunction) {
       "free_array(as_array((c as Value).prev, ptr)); free(as_heap(c)); "
       "free_array(as_array((a as Value).prev, ptr)); free(as_heap(a)); "
       "free_array(as_array((b as Value).prev, ptr)); free(as_heap(b))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
@@ -345,7 +230,6 @@ TEST(JitTests, AllocArrayHeapEscapesFunction) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_DOUBLE_EQ(std::atof(buf), 5.0) << "b.grad after backward should be 5, got " << buf;
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesTwoLibsCosAndPointSet) {
@@ -354,105 +238,45 @@ TEST(JitTests, ExecutesTwoLibsCosAndPointSet) {
   std::string src = "struct Point { x: f64; y: f64; }; extern lib \"libm.so.6\"; extern fn cos(x: f64) -> f64; extern lib \"";
   src += so_path;
   src += "\"; extern fn point_set(p: Point, x: f64, y: f64) -> void; extern fn point_x(p: Point) -> f64; let p = heap(Point); point_set(p, 1.0, 2.0); println(cos(0.0)); println(point_x(p)); free(as_heap(p))";
-  auto tokens = fusion::lex(src);
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << "parse failed: " << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run(src);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesInterleavedLetAndExpr) {
   /* Execution order must follow source order: println(1), then let x=2, println(x), let y=3, println(y). */
-  auto tokens = fusion::lex("println(1); let x = 2; println(x); let y = 3; println(y)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("println(1); let x = 2; println(x); let y = 3; println(y)");
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesIfWithComparison) {
   /* If/elif/else with comparisons: compile and run JIT. Verifies codegen for conditionals does not crash. */
-  auto tokens = fusion::lex(
+  auto jit_result = compile_and_run(
     "fn sign(x: i64) -> i64 { if (x > 0) { return 1; } elif (x < 0) { return 99; } else { return 0; } } "
     "println(sign(5)); println(sign(0)); println(sign(3))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
   EXPECT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesTopLevelIf) {
-  /* Top-level if/else: compile and run JIT, capture stdout (fd 1) and expect "1" and "2". */
-  auto tokens = fusion::lex("if (1 > 0) { println(1); } else { println(0); } println(2)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  std::string stdout_capture;
-  {
-    int pipe_fd[2];
-    ASSERT_EQ(pipe(pipe_fd), 0);
-    int saved_stdout = dup(STDOUT_FILENO);
-    ASSERT_GE(saved_stdout, 0);
-    dup2(pipe_fd[1], STDOUT_FILENO);
-    close(pipe_fd[1]);
-    auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-    fflush(stdout);
-    dup2(saved_stdout, STDOUT_FILENO);
-    close(saved_stdout);
-    ASSERT_TRUE(jit_result.ok) << jit_result.error;
-    char buf[256];
-    ssize_t n;
-    while ((n = read(pipe_fd[0], buf, sizeof(buf) - 1)) > 0) {
-      buf[n] = '\0';
-      stdout_capture += buf;
-    }
-    close(pipe_fd[0]);
-  }
-  EXPECT_TRUE(stdout_capture.find("1") != std::string::npos) << "captured: " << stdout_capture;
-  EXPECT_TRUE(stdout_capture.find("2") != std::string::npos) << "captured: " << stdout_capture;
+  /* Top-level if/else: compile and run JIT, capture output and expect "1" and "2". */
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("if (1 > 0) { println(1); } else { println(0); } println(2)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  EXPECT_TRUE(g_print_capture.find("1") != std::string::npos) << "captured: " << g_print_capture;
+  EXPECT_TRUE(g_print_capture.find("2") != std::string::npos) << "captured: " << g_print_capture;
 }
 
 TEST(JitTests, ExecutesAllocArrayAndIndex) {
   /* heap_array(i64, n), store via a[i]=v, load via a[i] and print */
-  const char* path = "/tmp/fusion_jit_array_index_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let a = heap_array(i64, 3); a[0] = 10; a[1] = 20; a[2] = 30; println(a[0]); println(a[1]); println(a[2]); free_array(a)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
@@ -462,34 +286,21 @@ TEST(JitTests, ExecutesAllocArrayAndIndex) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_STREQ(buf, "30\n");
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesHeapArrayF64Print) {
   /* heap_array(f64, n); fill with 1.5; println(x[i]) must print 1.5, not truncated to 1 */
-  const char* path = "/tmp/fusion_jit_heap_array_f64_print.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let a = 1.5; let n = 3; let x = heap_array(f64, n); "
       "for (let i = 0; i < n; i = i + 1) { x[i] = a; } "
       "println(x[0]); println(x[1]); println(x[2]); println(a); println(x[0]); "
       "free_array(as_array(x, f64))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   for (int i = 0; i < 5; ++i) {
@@ -497,33 +308,20 @@ TEST(JitTests, ExecutesHeapArrayF64Print) {
     EXPECT_NEAR(std::atof(buf), 1.5, 0.0001) << "line " << i << " expected 1.5, got " << buf;
   }
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesForOverF64Array) {
   /* for (let i = 0; i < len(arr); i = i + 1) { println(arr[i]); } with f64 array => 1.5, 1.5, 1.5 */
-  const char* path = "/tmp/fusion_jit_for_f64_arr.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let arr = heap_array(f64, 3); arr[0] = 1.5; arr[1] = 1.5; arr[2] = 1.5; "
       "for (let i = 0; i < len(arr); i = i + 1) { println(arr[i]); } "
       "free_array(as_array(arr, f64))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   for (int i = 0; i < 3; ++i) {
@@ -531,30 +329,17 @@ TEST(JitTests, ExecutesForOverF64Array) {
     EXPECT_NEAR(std::atof(buf), 1.5, 0.0001) << "line " << i << " expected 1.5, got " << buf;
   }
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesCStyleFor) {
   /* for (let i = 0; i < 5; i = i + 1) { println(i); } println(0) => prints 0,1,2,3,4 then 0 */
-  const char* path = "/tmp/fusion_jit_for_range_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("for (let i = 0; i < 5; i = i + 1) { println(i); } println(0)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("for (let i = 0; i < 5; i = i + 1) { println(i); } println(0)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   for (int expected = 0; expected < 5; ++expected) {
@@ -564,31 +349,18 @@ TEST(JitTests, ExecutesCStyleFor) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_EQ(std::atoi(buf), 0) << "trailing println(0)";
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesForOverArrayWithLen) {
   /* let arr = heap_array(i64, 3); arr[0]=1; ... for (let i = 0; i < len(arr); i = i + 1) { println(arr[i]); } println(0) => 1,2,3,0 */
-  const char* path = "/tmp/fusion_jit_for_arr_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let arr = heap_array(i64, 3); arr[0] = 1; arr[1] = 2; arr[2] = 3; for (let i = 0; i < len(arr); i = i + 1) { println(arr[i]); } println(0); free_array(arr)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
@@ -600,30 +372,17 @@ TEST(JitTests, ExecutesForOverArrayWithLen) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_STREQ(buf, "0\n");
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesCStyleForTwoArgs) {
   /* for (let x = 2; x < 6; x = x + 1) { println(x); } println(0) => 2,3,4,5,0 */
-  const char* path = "/tmp/fusion_jit_range_two_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("for (let x = 2; x < 6; x = x + 1) { println(x); } println(0)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("for (let x = 2; x < 6; x = x + 1) { println(x); } println(0)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   for (int expected = 2; expected <= 5; ++expected) {
@@ -633,30 +392,17 @@ TEST(JitTests, ExecutesCStyleForTwoArgs) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_EQ(std::atoi(buf), 0);
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesCStyleForF64) {
   /* for (let i = 0; i < 3; i = i + 1) { let x = i as f64; println(x); } println(0) => 0.0, 1.0, 2.0, 0 */
-  const char* path = "/tmp/fusion_jit_range_f64_test.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("for (let i = 0; i < 3; i = i + 1) { let x = i as f64; println(x); } println(0)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("for (let i = 0; i < 3; i = i + 1) { let x = i as f64; println(x); } println(0)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   for (double expected = 0.0; expected <= 2.0; expected += 1.0) {
@@ -666,86 +412,47 @@ TEST(JitTests, ExecutesCStyleForF64) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_EQ(std::atoi(buf), 0);
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesStackI64) {
-  const char* path = "/tmp/fusion_jit_stack_i64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let x = stack(i64); store(x, 42); println(load(x))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let x = stack(i64); store(x, 42); println(load(x))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 42);
 }
 
 TEST(JitTests, ExecutesStackF64) {
-  const char* path = "/tmp/fusion_jit_stack_f64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let x = stack(f64); store(x, 3.14); println(load_f64(x))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let x = stack(f64); store(x, 3.14); println(load_f64(x))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_NEAR(std::atof(buf), 3.14, 0.0001);
 }
 
 TEST(JitTests, ExecutesStackArray) {
-  const char* path = "/tmp/fusion_jit_stack_array.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let a = stack_array(i64, 3); a[0] = 1; a[1] = 2; a[2] = 3; println(a[0]); println(a[1]); println(a[2])");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   for (int expected = 1; expected <= 3; ++expected) {
@@ -753,100 +460,58 @@ TEST(JitTests, ExecutesStackArray) {
     EXPECT_EQ(std::atoi(buf), expected);
   }
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesStackArrayWithLen) {
-  const char* path = "/tmp/fusion_jit_stack_array_len.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let a = stack_array(i64, 5); println(len(a))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let a = stack_array(i64, 5); println(len(a))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 5);
 }
 
 TEST(JitTests, ExecutesHeapAndFree) {
-  auto tokens = fusion::lex("let p = heap(i64); store(p, 99); println(load(p)); free(p)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  const char* path = "/tmp/fusion_jit_heap_free.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let p = heap(i64); store(p, 99); println(load(p)); free(p)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 99);
 }
 
 TEST(JitTests, ExecutesHeapArrayAndFreeArray) {
-  const char* path = "/tmp/fusion_jit_heap_array_free.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let a = heap_array(i64, 4); a[0] = 10; println(a[0]); free_array(a)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let a = heap_array(i64, 4); a[0] = 10; println(a[0]); free_array(a)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 10);
 }
 
 TEST(JitTests, ExecutesFreeValueStyle) {
   /* Value struct with prev ptr; alloc_value, free_value using free_array(prev) and free(v). */
-  const char* path = "/tmp/fusion_jit_free_value.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct Value { data: f64; grad: f64; prev: ptr[void]; children_count: i64; backward: ptr[void]; }; "
       "fn free_value(v: ptr[void]) -> void { "
       "  let prev = (v as Value).prev; "
@@ -867,45 +532,26 @@ TEST(JitTests, ExecutesFreeValueStyle) {
       "(a as Value).grad = 7.0; "
       "println((a as Value).grad); "
       "free_value(a)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_NEAR(std::atof(buf), 7.0, 0.0001);
 }
 
 TEST(JitTests, ExecutesAsHeapForParam) {
-  auto tokens = fusion::lex(
+  auto jit_result = compile_and_run(
       "fn f(p: ptr[void]) -> void { free(as_heap(p)); } "
       "let x = heap(i64); f(x)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesAsArrayForLoadField) {
-  auto tokens = fusion::lex(
+  auto jit_result = compile_and_run(
       "struct V { prev: ptr[void]; }; "
       "fn free_v(v: ptr[void]) -> void { "
       "  free_array(as_array((v as V).prev, ptr)); "
@@ -915,69 +561,36 @@ TEST(JitTests, ExecutesAsArrayForLoadField) {
       "let v = heap(V); "
       "v.prev = p; "
       "free_v(v)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesHeapStruct) {
-  const char* path = "/tmp/fusion_jit_heap_struct.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct P { x: f64; y: f64; }; "
       "let p = heap(P); p.x = 1.0; p.y = 2.0; println(p.x); free(as_heap(p))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_NEAR(std::atof(buf), 1.0, 0.0001);
 }
 
 TEST(JitTests, ExecutesStackStruct) {
-  const char* path = "/tmp/fusion_jit_stack_struct.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct P { x: f64; y: f64; }; "
       "let p = stack(P); p.x = 1.0; p.y = 2.0; println(p.x); println(p.y)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
@@ -985,86 +598,51 @@ TEST(JitTests, ExecutesStackStruct) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_NEAR(std::atof(buf), 2.0, 0.0001);
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesLenOnStackArray) {
-  const char* path = "/tmp/fusion_jit_len_stack.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let a = stack_array(i64, 7); println(len(a))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let a = stack_array(i64, 7); println(len(a))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 7);
 }
 
 TEST(JitTests, ExecutesLenOnHeapArray) {
-  const char* path = "/tmp/fusion_jit_len_heap.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let a = heap_array(i64, 11); println(len(a)); free_array(a)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok());
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let a = heap_array(i64, 11); println(len(a)); free_array(a)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 11);
 }
 
 TEST(JitTests, FreeArrayF64Direct) {
   // heap_array(f64, 4); fill; free_array(as_array(a, f64)) must not leak
-  auto tokens = fusion::lex(
+  auto jit_result = compile_and_run(
       "let a = heap_array(f64, 4); "
       "a[0] = 1.0; a[1] = 2.0; a[2] = 3.0; a[3] = 4.0; "
       "free_array(as_array(a, f64))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, FreeMultipleF64ArraysTrainedWeightPattern) {
   // Simulates train.fusion's _trained arrays: W1(2x4=8), W2(4x1=4), b1(4), b2(1),
   // X(2), h1(4), h2(1) — all allocated and freed via as_array(_, f64).
-  auto tokens = fusion::lex(
+  auto jit_result = compile_and_run(
       "let W1 = heap_array(f64, 8); "
       "let W2 = heap_array(f64, 4); "
       "let b1 = heap_array(f64, 4); "
@@ -1081,39 +659,19 @@ TEST(JitTests, FreeMultipleF64ArraysTrainedWeightPattern) {
       "free_array(as_array(X,  f64)); "
       "free_array(as_array(h1, f64)); "
       "free_array(as_array(h2, f64))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
 }
 
 TEST(JitTests, ExecutesEqNeq) {
-  const char* path = "/tmp/fusion_jit_eqneq.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "if (2 == 2) { println(1); } else { println(0); } "
       "if (3 != 3) { println(1); } else { println(0); }");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
@@ -1121,30 +679,17 @@ TEST(JitTests, ExecutesEqNeq) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_STREQ(buf, "0\n") << "3 != 3 should be false";
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesLeGe) {
-  const char* path = "/tmp/fusion_jit_lege.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "for (let i = 0; i <= 3; i = i + 1) { println(i); }");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   for (int expected = 0; expected <= 3; ++expected) {
@@ -1152,30 +697,17 @@ TEST(JitTests, ExecutesLeGe) {
     EXPECT_EQ(std::atoi(buf), expected) << "loop body should print " << expected;
   }
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesGeDecrement) {
-  const char* path = "/tmp/fusion_jit_ge_decr.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "for (let i = 3; i >= 0; i = i - 1) { println(i); }");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   for (int expected = 3; expected >= 0; --expected) {
@@ -1183,217 +715,123 @@ TEST(JitTests, ExecutesGeDecrement) {
     EXPECT_EQ(std::atoi(buf), expected) << "decrement loop should print " << expected;
   }
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, ExecutesPrintString) {
-  const char* path = "/tmp/fusion_jit_print_str.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("println(\"hello\")");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(\"hello\")");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_STREQ(buf, "hello\n") << "println(\"hello\") should output hello";
 }
 
 TEST(JitTests, ExecutesToStrI64) {
-  const char* path = "/tmp/fusion_jit_to_str_i64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("println(to_str(42))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(to_str(42))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_STREQ(buf, "42\n") << "to_str(42) should produce \"42\"";
 }
 
 TEST(JitTests, ExecutesToStrF64) {
-  const char* path = "/tmp/fusion_jit_to_str_f64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("println(to_str(3.14))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(to_str(3.14))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_NEAR(std::atof(buf), 3.14, 0.001) << "to_str(3.14) should convert to string near 3.14";
 }
 
 TEST(JitTests, ExecutesStringConcat) {
-  const char* path = "/tmp/fusion_jit_str_concat.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let s = \"a\" + \"b\"; println(s); free(as_heap(s))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let s = \"a\" + \"b\"; println(s); free(as_heap(s))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_STREQ(buf, "ab\n") << "string + string should concatenate";
 }
 
 TEST(JitTests, ExecutesToStrConcat) {
   /* to_str uses a single static buffer; left must be copied before right is evaluated. */
-  const char* path = "/tmp/fusion_jit_to_str_concat.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let s = to_str(100) + to_str(2); println(s); free(as_heap(s))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let s = to_str(100) + to_str(2); println(s); free(as_heap(s))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_STREQ(buf, "1002\n") << "to_str(100) + to_str(2) should be 1002 not 22";
 }
 
 TEST(JitTests, ExecutesFromStrI64) {
-  const char* path = "/tmp/fusion_jit_from_str_i64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let s = to_str(123); let n = from_str(s, i64); println(n)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let s = to_str(123); let n = from_str(s, i64); println(n)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 123) << "from_str(to_str(123), i64) should return 123";
 }
 
 TEST(JitTests, ExecutesRecursiveFib) {
-  const char* path = "/tmp/fusion_jit_fib.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "fn fib(n: i64) -> i64 { "
       "  if (n <= 1) { return n; } "
       "  return fib(n - 1) + fib(n - 2); "
       "} "
       "println(fib(10))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 55) << "fib(10) should be 55";
 }
 
 TEST(JitTests, ExecutesLoadPtr) {
-  const char* path = "/tmp/fusion_jit_load_ptr.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let p = heap(ptr[void]); "
       "let q = heap(i64); "
       "store(p, q); "
@@ -1401,208 +839,116 @@ TEST(JitTests, ExecutesLoadPtr) {
       "store(r, 77); "
       "println(load(q)); "
       "free(as_heap(p)); free(as_heap(q))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 77) << "load_ptr + store roundtrip should yield 77";
 }
 
 TEST(JitTests, ExecutesLoadI32) {
   /* heap(i64) gives 8 bytes; store(p, 300) writes 300 as i64; load_i32(p) reads low 4 bytes as i32 */
-  const char* path = "/tmp/fusion_jit_load_i32.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let p = heap(i64); store(p, 300); println(load_i32(p)); free(as_heap(p))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let p = heap(i64); store(p, 300); println(load_i32(p)); free(as_heap(p))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 300) << "load_i32 on slot storing 300 should yield 300";
 }
 
 TEST(JitTests, ExecutesAddrOf) {
-  const char* path = "/tmp/fusion_jit_addr_of.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let x = 5; "
       "let p = addr_of(x); "
       "store(p, 77); "
       "println(load(p))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 77) << "store through addr_of should update local variable";
 }
 
 TEST(JitTests, ExecutesCastF64ToI64) {
-  const char* path = "/tmp/fusion_jit_cast_f64_i64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let x = 3.9; let y = x as i64; println(y)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let x = 3.9; let y = x as i64; println(y)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 3) << "3.9 as i64 should truncate to 3";
 }
 
 TEST(JitTests, ExecutesCastI64ToI32) {
   /* i64 -> i32 truncation: 300 fits in i32, then extend back to i64 for print */
-  const char* path = "/tmp/fusion_jit_cast_i64_i32.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex("let x = 300; let y = x as i32; println(y as i64)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("let x = 300; let y = x as i32; println(y as i64)");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 300) << "300 as i32 as i64 should round-trip to 300";
 }
 
 TEST(JitTests, ExecutesStructI64Field) {
-  const char* path = "/tmp/fusion_jit_struct_i64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct N { n: i64; }; "
       "let obj = heap(N); "
       "obj.n = 42; "
       "println(obj.n); "
       "free(as_heap(obj))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 42) << "obj.n = 42 / println(obj.n) for i64 field should yield 42";
 }
 
 TEST(JitTests, ExecutesPrintTwoArgs) {
   /* println(val, stream=2) writes to stderr; just verify jit_result.ok (no crash) */
-  auto tokens = fusion::lex("println(42, 2)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
+  auto jit_result = compile_and_run("println(42, 2)");
   EXPECT_TRUE(jit_result.ok) << "println(42, 2) to stderr should not crash: " << jit_result.error;
 }
 
 TEST(JitTests, ExecutesWriteFile) {
   const char* tmp = "/tmp/fusion_jit_write_file_test.txt";
   unlink(tmp);
-  auto tokens = fusion::lex(
+  auto jit_result = compile_and_run(
       std::string("let fh = open(\"") + tmp + "\", \"w\"); "
       "write_file(fh, 99); "
       "close(fh)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
   FILE* f = fopen(tmp, "r");
   ASSERT_NE(f, nullptr) << "temp file should exist after write_file";
@@ -1615,31 +961,18 @@ TEST(JitTests, ExecutesWriteFile) {
 
 TEST(JitTests, ExecutesFromStrF64) {
   /* from_str(to_str(3.14), f64) should recover 3.14; cast to i64 = 3 for deterministic print */
-  const char* path = "/tmp/fusion_jit_from_str_f64.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let s = to_str(3.14); let n = from_str(s, f64); let i = n as i64; println(i)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   EXPECT_EQ(std::atoi(buf), 3) << "from_str(to_str(3.14), f64) truncated to i64 should be 3";
 }
 
@@ -1647,258 +980,142 @@ TEST(JitTests, ExecutesReadLineFile) {
   const char* tmp = "/tmp/fusion_jit_read_line_in.txt";
   /* Write a known line from C */
   { FILE* f = fopen(tmp, "w"); ASSERT_NE(f, nullptr); fprintf(f, "hello_line\n"); fclose(f); }
-  const char* out_path = "/tmp/fusion_jit_read_line_out.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       std::string("let f = open(\"") + tmp + "\", \"r\"); "
       "let line = read_line_file(f); "
       "println(line); "
       "close(f)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
+  rt_set_print_sink(nullptr);
   unlink(tmp);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   /* read_line_file strips trailing newline; print re-adds it */
   EXPECT_STREQ(buf, "hello_line\n") << "read_line_file + print should output the line";
 }
 
 TEST(JitTests, ExecutesStrUpper) {
-  const char* out_path = "/tmp/fusion_jit_str_upper.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_upper(\"hello\"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_upper(\"hello\"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "HELLO\n");
 }
 
 TEST(JitTests, ExecutesStrLower) {
-  const char* out_path = "/tmp/fusion_jit_str_lower.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_lower(\"HELLO\"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_lower(\"HELLO\"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "hello\n");
 }
 
 TEST(JitTests, ExecutesStrContains) {
-  const char* out_path = "/tmp/fusion_jit_str_contains.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_contains(\"hello world\", \"world\"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_contains(\"hello world\", \"world\"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "1\n");
 }
 
 TEST(JitTests, ExecutesStrContainsNeg) {
-  const char* out_path = "/tmp/fusion_jit_str_contains_neg.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_contains(\"hello\", \"xyz\"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_contains(\"hello\", \"xyz\"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "0\n");
 }
 
 TEST(JitTests, ExecutesStrStrip) {
-  const char* out_path = "/tmp/fusion_jit_str_strip.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_strip(\"  hello  \"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_strip(\"  hello  \"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "hello\n");
 }
 
 TEST(JitTests, ExecutesStrFind) {
-  const char* out_path = "/tmp/fusion_jit_str_find.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_find(\"hello world\", \"world\"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_find(\"hello world\", \"world\"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "6\n");
 }
 
 TEST(JitTests, ExecutesStrFindNeg) {
-  const char* out_path = "/tmp/fusion_jit_str_find_neg.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex("println(str_find(\"hello\", \"xyz\"))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run("println(str_find(\"hello\", \"xyz\"))");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_STREQ(buf, "-1\n");
 }
 
 TEST(JitTests, ExecutesStrSplit) {
-  const char* out_path = "/tmp/fusion_jit_str_split.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let p = str_split(\"a,b,c\", \",\"); "
       "println(len(p)); "
       "println(p[0])");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
@@ -1906,83 +1123,54 @@ TEST(JitTests, ExecutesStrSplit) {
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_STREQ(buf, "a\n");
   fclose(cap);
-  unlink(out_path);
 }
 
 TEST(JitTests, ExecutesHttpRequestGet) {
   /* Requires libcurl and network. GET example.com, check status 200 and non-null body. */
-  const char* out_path = "/tmp/fusion_jit_http_out.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "let body = http_request(\"GET\", \"https://example.com\", \"\"); "
       "let code = http_status(); "
       "println(code); "
       "println(\"ok\");");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  /* best-effort restore of stdout FILE*; fd already restored by dup2 */
-  if (!freopen("/dev/fd/1", "w", stdout)) { (void)0; }
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   if (strcmp(buf, "200\n") != 0) {
     fclose(cap);
-    unlink(out_path);
-    GTEST_SKIP() << "http_request to example.com failed (no network or non-200); skipping";
+      GTEST_SKIP() << "http_request to example.com failed (no network or non-200); skipping";
   }
   EXPECT_STREQ(buf, "200\n") << "http_status() should be 200 for example.com";
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_TRUE(std::string(buf).find("ok") != std::string::npos) << "expected ok line";
   fclose(cap);
-  unlink(out_path);
 }
 
 TEST(JitTests, ExecutesLineCountFile) {
   const char* tmp = "/tmp/fusion_jit_line_count_in.txt";
   /* Write 3 lines from C */
   { FILE* f = fopen(tmp, "w"); ASSERT_NE(f, nullptr); fprintf(f, "a\nb\nc\n"); fclose(f); }
-  const char* out_path = "/tmp/fusion_jit_line_count_out.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       std::string("let f = open(\"") + tmp + "\", \"r\"); "
       "let n = line_count_file(f); "
       "close(f); "
       "println(n)");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
+  rt_set_print_sink(nullptr);
   unlink(tmp);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_EQ(std::atoi(buf), 3) << "line_count_file should count 3 newlines in 3-line file";
 }
 
@@ -1990,11 +1178,9 @@ TEST(JitTests, ExecutesWriteBytesReadBytes) {
   /* Write 8 bytes (i64 = 54321) to a binary file, read back, and verify via print */
   const char* tmp = "/tmp/fusion_jit_wb_rb.bin";
   unlink(tmp);
-  const char* out_path = "/tmp/fusion_jit_wb_rb_out.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(out_path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       std::string(
       "let buf = heap_array(i64, 1); "
       "buf[0] = 54321; "
@@ -2008,36 +1194,23 @@ TEST(JitTests, ExecutesWriteBytesReadBytes) {
       "println(buf2[0]); "
       "free_array(as_array(buf, i64)); "
       "free_array(as_array(buf2, i64))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
+  rt_set_print_sink(nullptr);
   unlink(tmp);
   ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(out_path, "r");
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(out_path);
   EXPECT_EQ(std::atoi(buf), 54321) << "write_bytes/read_bytes roundtrip should recover 54321";
 }
 
 TEST(JitTests, TypedPtrArrayFieldRead) {
   /* heap_array(ptr[S], n); store ptr into arr[0]; read arr[0].x without a cast */
-  const char* path = "/tmp/fusion_jit_typed_ptr_array_field_read.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct S { x: i64; y: f64; }; "
       "fn make_s(v: i64) -> ptr[void] { "
       "  let s = heap(S); "
@@ -2055,20 +1228,10 @@ TEST(JitTests, TypedPtrArrayFieldRead) {
       "free(as_heap(arr[0])); "
       "free(as_heap(arr[1])); "
       "free_array(as_array(arr, ptr))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char line[32];
   ASSERT_NE(fgets(line, sizeof(line), cap), nullptr);
@@ -2076,41 +1239,27 @@ TEST(JitTests, TypedPtrArrayFieldRead) {
   ASSERT_NE(fgets(line, sizeof(line), cap), nullptr);
   EXPECT_EQ(std::atoi(line), 99) << "arr[1].x should be 99";
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, TypedPtrParamFieldAccess) {
   /* fn get_data(v: ptr[Value]) -> f64 { return v.data; } — ptr[T] param enables field access */
-  const char* path = "/tmp/fusion_jit_typed_ptr_param_field.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct Value { data: f64; }; "
       "fn get_data(v: ptr[Value]) -> f64 { return v.data; } "
       "let val = heap(Value); "
       "val.data = 3.14; "
       "println(get_data(val)); "
       "free(as_heap(val))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[64];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   fclose(cap);
-  unlink(path);
   double result = std::atof(buf);
   EXPECT_NEAR(result, 3.14, 0.001) << "get_data should return v.data = 3.14";
 }
@@ -2120,11 +1269,9 @@ TEST(JitTests, CastIndexIntoBarePtrArrayThenFieldAccess) {
    *   let arr = heap_array(ptr, n);   // bare ptr array
    *   let data = (arr[0] as Value).data;
    * Previously failed sema with "cannot determine struct type of base expression" */
-  const char* path = "/tmp/fusion_jit_cast_index_field.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct Value { data: f64; grad: f64; }; "
       "let arr = heap_array(ptr[void], 2); "
       "let v0 = heap(Value); "
@@ -2142,20 +1289,10 @@ TEST(JitTests, CastIndexIntoBarePtrArrayThenFieldAccess) {
       "free(as_heap(v0)); "
       "free(as_heap(v1)); "
       "free_array(as_array(arr, ptr))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char line[32];
   ASSERT_NE(fgets(line, sizeof(line), cap), nullptr);
@@ -2163,16 +1300,13 @@ TEST(JitTests, CastIndexIntoBarePtrArrayThenFieldAccess) {
   ASSERT_NE(fgets(line, sizeof(line), cap), nullptr);
   EXPECT_NEAR(std::atof(line), 2.5, 0.001) << "(arr[1] as Value).data should be 2.5";
   fclose(cap);
-  unlink(path);
 }
 
 TEST(JitTests, LetBindingFromCastFieldAccess) {
   /* let w = arr[i] as Value; w.data and w.grad are accessible */
-  const char* path = "/tmp/fusion_jit_let_cast_field.txt";
-  int saved_fd = dup(STDOUT_FILENO);
-  ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
-  auto tokens = fusion::lex(
+  g_print_capture.clear();
+  rt_set_print_sink(jit_print_capture);
+  auto jit_result = compile_and_run(
       "struct Value { data: f64; grad: f64; }; "
       "let arr = heap_array(ptr[void], 1); "
       "let v = heap(Value); "
@@ -2184,25 +1318,14 @@ TEST(JitTests, LetBindingFromCastFieldAccess) {
       "println(sum); "
       "free(as_heap(v)); "
       "free_array(as_array(arr, ptr))");
-  auto parse_result = fusion::parse(tokens);
-  ASSERT_TRUE(parse_result.ok()) << parse_result.error.message;
-  auto sema_result = fusion::check(parse_result.program.get());
-  ASSERT_TRUE(sema_result.ok) << sema_result.error.message;
-  auto ctx = std::make_unique<llvm::LLVMContext>();
-  auto module = fusion::codegen(*ctx, parse_result.program.get());
-  ASSERT_NE(module, nullptr);
-  auto jit_result = fusion::run_jit(std::move(module), std::move(ctx));
-  fflush(stdout);
-  dup2(saved_fd, STDOUT_FILENO);
-  close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
-  ASSERT_TRUE(jit_result.ok) << jit_result.error;
-  FILE* cap = fopen(path, "r");
+  rt_set_print_sink(nullptr);
+  ASSERT_TRUE(jit_result.ok) << jit_result.error;
+  ASSERT_FALSE(g_print_capture.empty());
+  FILE* cap = fmemopen(&g_print_capture[0], g_print_capture.size(), "r");
   ASSERT_NE(cap, nullptr);
   char buf[32];
   ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
   EXPECT_NEAR(std::atof(buf), 12.0, 0.001) << "w.data + w.grad should be 12.0";
   fclose(cap);
-  unlink(path);
 }
 #endif
@@ -5,42 +5,37 @@
 #include "parser.hpp"
 #include "sema.hpp"
 #include <gtest/gtest.h>
-#include <cstdio>
-#include <fstream>
+#include <map>
 #include <memory>
 #include <string>
-#include <unistd.h>
 
 #ifdef FUSION_HAVE_LLVM
 #include <llvm/IR/LLVMContext.h>
 #endif
 
-// Helper: create temp dir, write library_file_content to lib_name.fusion, parse main_source, run resolve_imports_and_merge.
+// Helper: serve library_file_content as lib_name.fusion through the in-memory
+// import resolver, parse main_source, run resolve_imports_and_merge.
 // Returns (error_message, merged_program). If error_message is non-empty, merge failed.
 static std::pair<std::string, fusion::ProgramPtr> run_multifile_merge(
     const std::string& main_source,
     const std::string& lib_name,
     const std::string& library_file_content) {
-  char dir_tpl[] = "/tmp/fusion_mf_XXXXXX";
-  if (!mkdtemp(dir_tpl)) return {"mkdtemp failed", nullptr};
-  std::string dir(dir_tpl);
-  std::string lib_path = dir + "/" + lib_name + ".fusion";
-  std::ofstream lib_file(lib_path);
-  if (!lib_file) { rmdir(dir_tpl); return {"cannot write lib file", nullptr}; }
-  lib_file << library_file_content;
-  lib_file.close();
+  std::string lib_path = "/fusion_mf/" + lib_name + ".fusion";
+  fusion::set_import_source_resolver(
+      [&lib_path, &library_file_content](const std::string& path, std::string* out) {
+        if (path != lib_path) return false;
+        *out = library_file_content;
+        return true;
+      });
 
   auto tokens = fusion::lex(main_source);
   auto parse_result = fusion::parse(tokens);
   if (!parse_result.ok()) {
-    unlink(lib_path.c_str());
-    rmdir(dir_tpl);
+    fusion::set_import_source_resolver(nullptr);
     return {"parse failed: " + parse_result.error.message, nullptr};
   }
-  std::string main_path = dir + "/main.fusion";
-  std::string err = fusion::resolve_imports_and_merge(main_path, parse_result.program.get());
-  unlink(lib_path.c_str());
-  rmdir(dir_tpl);
+  std::string err = fusion::resolve_imports_and_merge("/fusion_mf/main.fusion", parse_result.program.get());
+  fusion::set_import_source_resolver(nullptr);
   if (!err.empty()) return {err, nullptr};
   return {"", std::move(parse_result.program)};
 }
@@ -222,21 +217,21 @@ print(1))";
 }
 
 TEST(MultifileTests, CircularImportReturnsError) {
-  char dir_tpl[] = "/tmp/fusion_mf_XXXXXX";
-  ASSERT_TRUE(mkdtemp(dir_tpl));
-  std::string dir(dir_tpl);
-  std::string a_path = dir + "/a.fusion";
-  std::string b_path = dir + "/b.fusion";
-  std::ofstream(a_path) << "import lib \"b\" { }; print(1)";
-  std::ofstream(b_path) << "import lib \"a\" { }; print(1)";
+  std::map<std::string, std::string> sources = {
+      {"/fusion_mf/a.fusion", "import lib \"b\" { }; print(1)"},
+      {"/fusion_mf/b.fusion", "import lib \"a\" { }; print(1)"},
+  };
+  fusion::set_import_source_resolver([&sources](const std::string& path, std::string* out) {
+    auto it = sources.find(path);
+    if (it == sources.end()) return false;
+    *out = it->second;
+    return true;
+  });
   auto tokens = fusion::lex("import lib \"a\" { }; print(1)");
   auto result = fusion::parse(tokens);
   ASSERT_TRUE(result.ok());
-  std::string main_path = dir + "/main.fusion";
-  std::string err = fusion::resolve_imports_and_merge(main_path, result.program.get());
-  unlink(a_path.c_str());
-  unlink(b_path.c_str());
-  rmdir(dir_tpl);
+  std::string err = fusion::resolve_imports_and_merge("/fusion_mf/main.fusion", result.program.get());
+  fusion::set_import_source_resolver(nullptr);
   EXPECT_FALSE(err.empty());
   EXPECT_TRUE(err.find("circular") != std::string::npos);
 }
@@ -667,3 +667,17 @@ TEST(ParserTests, RejectsBarePtr) {
   auto result = fusion::parse(tokens);
   EXPECT_FALSE(result.ok()) << "expected parse failure for bare ptr param";
 }
+
+TEST(ParserTests, ParseSingleExprReturnsExprDirectly) {
+  auto tokens = fusion::lex("1+2");
+  auto expr = fusion::parse_single_expr(tokens);
+  ASSERT_TRUE(expr);
+  EXPECT_EQ(expr->kind, fusion::Expr::Kind::BinaryOp);
+  EXPECT_EQ(expr->bin_op, fusion::BinOp::Add);
+}
+
+TEST(ParserTests, ParseSingleExprRejectsTrailingTokens) {
+  auto tokens = fusion::lex("1+2 3");
+  auto expr = fusion::parse_single_expr(tokens);
+  EXPECT_FALSE(expr) << "expected failure for trailing tokens after expression";
+}
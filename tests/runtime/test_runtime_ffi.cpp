@@ -8,12 +8,12 @@
 #include <unistd.h>
 
 static bool ffi_available() {
-  rt_ffi_sig_t* sig = rt_ffi_sig_create(RT_FFI_I64, 0, nullptr);
-  if (sig == nullptr) {
-    const char* err = rt_ffi_error_last();
-    return err && strstr(err, "not available") != nullptr ? false : false;
-  }
-  return true;
+  /* Whether the runtime was built with libffi cannot change mid-process;
+   * probe once and reuse the answer. */
+  static const bool available = []() {
+    return rt_ffi_sig_create(RT_FFI_I64, 0, nullptr) != nullptr;
+  }();
+  return available;
 }
 
 TEST(RuntimeFfiTests, FfiNegative) {
@@ -72,10 +72,15 @@ TEST(RuntimeFfiTests, CallCos) {
 TEST(RuntimeFfiTests, CallPuts) {
   if (!ffi_available())
     GTEST_SKIP() << "FFI not available";
-  const char* path = "/tmp/fusion_ffi_puts_test.txt";
+  /* puts() writes via libc stdio, so capture at fd level with a pipe (the
+   * output is tiny, far below the pipe buffer). */
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
   int saved_fd = dup(STDOUT_FILENO);
   ASSERT_GE(saved_fd, 0);
-  ASSERT_TRUE(freopen(path, "w", stdout));
+  fflush(stdout);
+  ASSERT_GE(dup2(fds[1], STDOUT_FILENO), 0);
+  close(fds[1]);
   rt_ffi_type_kind_t arg_kinds[] = {RT_FFI_PTR};
   rt_ffi_sig_t* sig = rt_ffi_sig_create(RT_FFI_I32, 1, arg_kinds);
   ASSERT_NE(sig, nullptr) << (rt_ffi_error_last() ? rt_ffi_error_last() : "unknown");
@@ -87,18 +92,40 @@ TEST(RuntimeFfiTests, CallPuts) {
   fflush(stdout);
   dup2(saved_fd, STDOUT_FILENO);
   close(saved_fd);
-  ASSERT_TRUE(freopen("/dev/fd/1", "w", stdout));
 
-  FILE* cap = fopen(path, "r");
-  ASSERT_NE(cap, nullptr);
   char buf[64];
-  ASSERT_NE(fgets(buf, sizeof(buf), cap), nullptr);
-  fclose(cap);
-  unlink(path);
+  memset(buf, 0, sizeof(buf));
+  ssize_t nread = read(fds[0], buf, sizeof(buf) - 1);
+  close(fds[0]);
+  ASSERT_GT(nread, 0);
   EXPECT_STREQ(buf, "fusion_puts_test\n");
   EXPECT_GE(static_cast<int32_t>(ret_buf & 0xFFFFFFFFu), 0);
 }
 
+TEST(RuntimeFfiTests, CallManyStrlen) {
+  if (!ffi_available())
+    GTEST_SKIP() << "FFI not available";
+  rt_ffi_type_kind_t arg_kinds[] = {RT_FFI_PTR};
+  rt_ffi_sig_t* sig = rt_ffi_sig_create(RT_FFI_I64, 1, arg_kinds);
+  ASSERT_NE(sig, nullptr) << (rt_ffi_error_last() ? rt_ffi_error_last() : "unknown");
+  const char* strs[] = {"a", "bb", "ccc"};
+  uint64_t args_buf[3];
+  for (int i = 0; i < 3; i++)
+    args_buf[i] = reinterpret_cast<uintptr_t>(strs[i]);
+  int64_t ret_vals[3] = {0, 0, 0};
+  EXPECT_EQ(rt_ffi_call_many(sig, (void*)strlen, args_buf, sizeof(uint64_t), 3,
+                             ret_vals, sizeof(int64_t)),
+            0)
+      << (rt_ffi_error_last() ? rt_ffi_error_last() : "");
+  EXPECT_EQ(ret_vals[0], 1);
+  EXPECT_EQ(ret_vals[1], 2);
+  EXPECT_EQ(ret_vals[2], 3);
+
+  EXPECT_NE(rt_ffi_call_many(nullptr, (void*)strlen, args_buf, 8, 1, ret_vals, 8), 0);
+  EXPECT_TRUE(rt_ffi_error_last() && strstr(rt_ffi_error_last(), "null signature"));
+  EXPECT_EQ(rt_ffi_call_many(sig, (void*)strlen, nullptr, 8, 0, nullptr, 8), 0);
+}
+
 TEST(RuntimeFfiTests, Phase6LayoutCrossCheck) {
   const char* so_path = std::getenv("FUSION_PHASE6_SO");
   if (!so_path) so_path = "./fusion_phase6.so";